@@ -25,7 +25,27 @@
 
 #include "jaxup_generator.h"
 #include "jaxup_parser.h"
+#include "jaxup_aggregate.h"
+#include "jaxup_builder.h"
+#include "jaxup_canonical.h"
+#include "jaxup_checkpoint.h"
+#include "jaxup_compact.h"
+#include "jaxup_csv.h"
+#include "jaxup_filter.h"
+#include "jaxup_index.h"
+#include "jaxup_log_sink.h"
+#include "jaxup_ndjson.h"
 #include "jaxup_node.h"
+#include "jaxup_parallel_writer.h"
+#include "jaxup_patch.h"
+#include "jaxup_path.h"
+#include "jaxup_pipeline.h"
+#include "jaxup_pool.h"
+#include "jaxup_query.h"
+#include "jaxup_recycler.h"
+#include "jaxup_sort.h"
+#include "jaxup_stats.h"
+#include "jaxup_thread_pool.h"
 #include <memory>
 
 namespace jaxup {
@@ -47,6 +67,26 @@ public:
 		return std::make_shared<JsonGenerator<FILE*>>(outputFile, prettyPrint);
 	}
 };
+
+// Drop-in alternative to JsonFactory that hands out recycled parsers and
+// generators.  They return to the pool when their handle goes out of scope.
+class JsonPooledFactory {
+public:
+	JsonPoolHandle<JsonParser<std::istream>> createJsonParser(std::istream& inputStream) {
+		return acquireJsonParser(inputStream);
+	}
+	JsonPoolHandle<JsonParser<FILE*>> createJsonParser(FILE* inputFile) {
+		return acquireJsonParser(inputFile);
+	}
+	JsonPoolHandle<JsonGenerator<std::ostream>> createJsonGenerator(
+		std::ostream& outputStream, bool prettyPrint = false) {
+		return acquireJsonGenerator(outputStream, prettyPrint);
+	}
+	JsonPoolHandle<JsonGenerator<FILE*>> createJsonGenerator(
+		FILE* outputFile, bool prettyPrint = false) {
+		return acquireJsonGenerator(outputFile, prettyPrint);
+	}
+};
 }
 
 #endif
@@ -0,0 +1,712 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+
+#ifndef JAXUP_AGGREGATE_H
+#define JAXUP_AGGREGATE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "jaxup_common.h"
+#include "jaxup_generator.h"
+#include "jaxup_ndjson.h"
+#include "jaxup_node.h"
+#include "jaxup_parser.h"
+#include "jaxup_path.h"
+#include "jaxup_query.h"
+#include "jaxup_thread_pool.h"
+
+namespace jaxup {
+
+// Approximate distinct counting in a fixed 2^precision bytes
+class JsonHyperLogLog {
+public:
+	explicit JsonHyperLogLog(unsigned int precision = 12) : precision(precision), registers(size_t(1) << precision, 0) {
+		if (precision < 4 || precision > 18) {
+			throw JsonException("HyperLogLog precision must be between 4 and 18");
+		}
+	}
+
+	void add(uint64_t hash) {
+		size_t index = static_cast<size_t>(hash >> (64 - precision));
+		uint64_t rest = hash << precision;
+		uint8_t rank = 1;
+		while (rank <= 64 - precision && (rest & (uint64_t(1) << 63)) == 0) {
+			++rank;
+			rest <<= 1;
+		}
+		registers[index] = std::max(registers[index], rank);
+	}
+
+	void merge(const JsonHyperLogLog& other) {
+		if (other.precision != precision) {
+			throw JsonException("Cannot merge HyperLogLogs of different precisions");
+		}
+		for (size_t i = 0; i < registers.size(); ++i) {
+			registers[i] = std::max(registers[i], other.registers[i]);
+		}
+	}
+
+	double estimate() const {
+		const double m = static_cast<double>(registers.size());
+		double sum = 0.0;
+		size_t zeroes = 0;
+		for (uint8_t r : registers) {
+			sum += std::ldexp(1.0, -static_cast<int>(r));
+			zeroes += r == 0;
+		}
+		double alpha = 0.7213 / (1.0 + 1.079 / m);
+		double estimate = alpha * m * m / sum;
+		if (estimate <= 2.5 * m && zeroes > 0) {
+			// Linear counting is more accurate for small sets
+			estimate = m * std::log(m / static_cast<double>(zeroes));
+		}
+		return estimate;
+	}
+
+private:
+	unsigned int precision;
+	std::vector<uint8_t> registers;
+};
+
+enum class JsonAggregateFunction {
+	// Counts records, or with a path the records where it isn't null
+	COUNT,
+	SUM,
+	MIN,
+	MAX,
+	MEAN,
+	// Approximate number of distinct scalar values
+	DISTINCT
+};
+
+static inline const char* getAggregateFunctionAsString(JsonAggregateFunction function) {
+	switch (function) {
+	case JsonAggregateFunction::COUNT:
+		return "count";
+	case JsonAggregateFunction::SUM:
+		return "sum";
+	case JsonAggregateFunction::MIN:
+		return "min";
+	case JsonAggregateFunction::MAX:
+		return "max";
+	case JsonAggregateFunction::MEAN:
+		return "mean";
+	default:
+		return "distinct";
+	}
+}
+
+// Groups records by the values at one or more paths and computes aggregates
+// over the values at others.  Group values are taken from the first match of
+// their path, while aggregates take in every match, so .items[*].price sums
+// the prices of all items.  Fields that no path leads to are skipped without
+// being converted.  Partial aggregators (one per thread, say) with the same
+// configuration can be merged.
+class JsonAggregator {
+public:
+	JsonAggregator& groupBy(const std::string& path) {
+		patterns.emplace(patterns.begin() + static_cast<std::ptrdiff_t>(groupPaths.size()), path);
+		groupPaths.push_back(path);
+		for (auto& metric : metrics) {
+			if (metric.pattern != noPattern) {
+				++metric.pattern;
+			}
+		}
+		groups.clear();
+		return *this;
+	}
+
+	// The path is ignored for COUNT without one.  Results are named after the
+	// function and path unless a name is given.
+	JsonAggregator& add(JsonAggregateFunction function, const std::string& path = std::string(), const std::string& name = std::string()) {
+		Metric metric;
+		metric.function = function;
+		metric.name = name.empty() ? std::string(getAggregateFunctionAsString(function)) + (path.empty() ? "" : "(" + path + ")") : name;
+		if (!path.empty()) {
+			metric.pattern = patterns.size();
+			patterns.emplace_back(path);
+		} else if (function != JsonAggregateFunction::COUNT) {
+			throw JsonException("Aggregate ", metric.name, " needs a path");
+		}
+		metrics.push_back(metric);
+		groups.clear();
+		return *this;
+	}
+
+	// An empty aggregator with the same configuration
+	JsonAggregator cloneEmpty() const {
+		JsonAggregator copy;
+		copy.groupPaths = groupPaths;
+		copy.patterns = patterns;
+		copy.metrics = metrics;
+		return copy;
+	}
+
+	// Aggregates every top level value in the stream.  Returns the number of
+	// records read.
+	template <class source>
+	uint64_t aggregate(JsonParser<source>& parser, size_t maxDepth = 50) {
+		uint64_t count = 0;
+		if (parser.currentToken() == JsonToken::NOT_AVAILABLE) {
+			parser.nextToken();
+		}
+		while (parser.currentToken() != JsonToken::NOT_AVAILABLE) {
+			aggregateValue(parser, maxDepth);
+			++count;
+		}
+		return count;
+	}
+
+	// Aggregates newline delimited records on a thread pool, with one partial
+	// aggregator per worker.  Returns the number of records read.
+	uint64_t aggregate(FILE* input, JsonThreadPool& pool, size_t maxDepth = 50) {
+		std::vector<JsonAggregator> partials;
+		std::vector<uint64_t> counts(pool.size(), 0);
+		for (size_t i = 0; i < pool.size(); ++i) {
+			partials.push_back(cloneEmpty());
+		}
+		JsonNdjsonProcessor processor(pool);
+		processor.process(input, [&](JsonParser<std::string>& parser, std::string&) {
+			size_t worker = JsonThreadPool::currentWorker();
+			counts[worker] += partials[worker].aggregate(parser, maxDepth);
+		}, [](const std::string&) {
+		});
+		uint64_t count = 0;
+		for (size_t i = 0; i < partials.size(); ++i) {
+			merge(partials[i]);
+			count += counts[i];
+		}
+		return count;
+	}
+
+	// Aggregates the value at the parser's current token, leaving the parser
+	// on the token after it.
+	template <class source>
+	void aggregateValue(JsonParser<source>& parser, size_t maxDepth = 50) {
+		groupValues.resize(groupPaths.size());
+		for (auto& value : groupValues) {
+			value.makeNull();
+		}
+		observations.clear();
+		path.clear();
+		extract(parser, maxDepth);
+
+		groupKey.clear();
+		for (const auto& value : groupValues) {
+			appendGroupKey(groupKey, value);
+		}
+		Group& group = findGroup(groupKey, groupValues);
+		for (const auto& observation : observations) {
+			group.states[observation.metric].add(observation);
+		}
+		// Path-less counts see every record
+		for (size_t i = 0; i < metrics.size(); ++i) {
+			if (metrics[i].pattern == noPattern) {
+				++group.states[i].count;
+			}
+		}
+	}
+
+	void merge(const JsonAggregator& other) {
+		if (other.patterns.size() != patterns.size() || other.metrics.size() != metrics.size()) {
+			throw JsonException("Cannot merge aggregators with different configurations");
+		}
+		for (const auto& entry : other.groups) {
+			const Group& theirs = *entry.second;
+			Group& ours = findGroup(entry.first, theirs.values);
+			for (size_t i = 0; i < metrics.size(); ++i) {
+				ours.states[i].merge(theirs.states[i]);
+			}
+		}
+	}
+
+	size_t numGroups() const {
+		return groups.size();
+	}
+
+	// Writes one object per group, ordered by group values, holding the group
+	// values under their paths and the aggregates under their names.
+	template <class dest>
+	void write(JsonGenerator<dest>& generator) const {
+		std::vector<const Group*> sorted;
+		for (const auto& entry : groups) {
+			sorted.push_back(entry.second.get());
+		}
+		std::sort(sorted.begin(), sorted.end(), [](const Group* a, const Group* b) {
+			for (size_t i = 0; i < a->values.size(); ++i) {
+				int result = compareJsonNodes(a->values[i], b->values[i]);
+				if (result != 0) {
+					return result < 0;
+				}
+			}
+			return false;
+		});
+		for (const Group* group : sorted) {
+			generator.startObject();
+			for (size_t i = 0; i < groupPaths.size(); ++i) {
+				generator.writeFieldName(groupPaths[i]);
+				group->values[i].write(generator);
+			}
+			for (size_t i = 0; i < metrics.size(); ++i) {
+				generator.writeFieldName(metrics[i].name);
+				group->states[i].write(metrics[i].function, generator);
+			}
+			generator.endObject();
+		}
+	}
+
+private:
+	static const size_t noPattern = static_cast<size_t>(-1);
+
+	struct Metric {
+		JsonAggregateFunction function = JsonAggregateFunction::COUNT;
+		std::string name;
+		size_t pattern = noPattern;
+	};
+
+	struct Observation {
+		size_t metric;
+		JsonToken token;
+		int64_t integer;
+		double number;
+		uint64_t hash;
+	};
+
+	struct State {
+		uint64_t count = 0;
+		double sum = 0.0;
+		int64_t integerSum = 0;
+		bool integersOnly = true;
+		double min = std::numeric_limits<double>::infinity();
+		double max = -std::numeric_limits<double>::infinity();
+		std::unique_ptr<JsonHyperLogLog> distinct;
+
+		void add(const Observation& observation) {
+			++count;
+			if (observation.token == JsonToken::VALUE_NUMBER_INT) {
+				int64_t value = observation.integer;
+				if ((value > 0 && integerSum > INT64_MAX - value) || (value < 0 && integerSum < INT64_MIN - value)) {
+					integersOnly = false;
+				}
+				integerSum += integersOnly ? value : 0;
+			} else if (observation.token == JsonToken::VALUE_NUMBER_FLOAT) {
+				integersOnly = false;
+			}
+			sum += observation.number;
+			min = std::min(min, observation.number);
+			max = std::max(max, observation.number);
+			if (distinct) {
+				distinct->add(observation.hash);
+			}
+		}
+
+		void merge(const State& other) {
+			count += other.count;
+			if (integersOnly && other.integersOnly) {
+				if ((other.integerSum > 0 && integerSum > INT64_MAX - other.integerSum) || (other.integerSum < 0 && integerSum < INT64_MIN - other.integerSum)) {
+					integersOnly = false;
+				} else {
+					integerSum += other.integerSum;
+				}
+			} else {
+				integersOnly = false;
+			}
+			sum += other.sum;
+			min = std::min(min, other.min);
+			max = std::max(max, other.max);
+			if (distinct && other.distinct) {
+				distinct->merge(*other.distinct);
+			}
+		}
+
+		template <class dest>
+		void writeNumber(JsonGenerator<dest>& generator, double value) const {
+			if (integersOnly && std::abs(value) < 9007199254740992.0) {
+				generator.write(static_cast<int64_t>(value));
+			} else {
+				generator.write(value);
+			}
+		}
+
+		template <class dest>
+		void write(JsonAggregateFunction function, JsonGenerator<dest>& generator) const {
+			switch (function) {
+			case JsonAggregateFunction::COUNT:
+				generator.write(static_cast<int64_t>(count));
+				break;
+			case JsonAggregateFunction::SUM:
+				if (integersOnly) {
+					generator.write(integerSum);
+				} else {
+					generator.write(sum);
+				}
+				break;
+			case JsonAggregateFunction::MIN:
+			case JsonAggregateFunction::MAX:
+				if (count == 0) {
+					generator.write(nullptr);
+				} else {
+					writeNumber(generator, function == JsonAggregateFunction::MIN ? min : max);
+				}
+				break;
+			case JsonAggregateFunction::MEAN:
+				if (count == 0) {
+					generator.write(nullptr);
+				} else {
+					generator.write(sum / static_cast<double>(count));
+				}
+				break;
+			case JsonAggregateFunction::DISTINCT:
+				generator.write(static_cast<int64_t>(std::llround(distinct ? distinct->estimate() : 0.0)));
+				break;
+			}
+		}
+	};
+
+	struct Group {
+		std::vector<JsonNode> values;
+		std::vector<State> states;
+	};
+
+	std::vector<std::string> groupPaths;
+	// Group paths first, then metric paths
+	std::vector<JsonPath> patterns;
+	std::vector<Metric> metrics;
+	std::unordered_map<std::string, std::unique_ptr<Group>> groups;
+
+	// Scratch space for the record being aggregated
+	std::vector<JsonNode> groupValues;
+	std::vector<Observation> observations;
+	std::vector<JsonPathElement> path;
+	std::string groupKey;
+
+	Group& findGroup(const std::string& key, const std::vector<JsonNode>& values) {
+		auto it = groups.find(key);
+		if (it != groups.end()) {
+			return *it->second;
+		}
+		std::unique_ptr<Group> group(new Group);
+		group->values.resize(values.size());
+		for (size_t i = 0; i < values.size(); ++i) {
+			values[i].copyTo(group->values[i]);
+		}
+		group->states.resize(metrics.size());
+		for (size_t i = 0; i < metrics.size(); ++i) {
+			if (metrics[i].function == JsonAggregateFunction::DISTINCT) {
+				group->states[i].distinct.reset(new JsonHyperLogLog);
+			}
+		}
+		Group& result = *group;
+		groups.emplace(key, std::move(group));
+		return result;
+	}
+
+	static void appendGroupKey(std::string& key, const JsonNode& value) {
+		switch (value.getType()) {
+		case JsonNodeType::VALUE_STRING:
+			key += 's' + std::to_string(value.asString().size()) + ':';
+			key += value.asString();
+			break;
+		case JsonNodeType::VALUE_NUMBER_INT:
+			key += 'i' + std::to_string(value.asInteger()) + ';';
+			break;
+		case JsonNodeType::VALUE_NUMBER_FLOAT: {
+			double d = value.asDouble();
+			if (d == std::floor(d) && std::abs(d) < 9007199254740992.0) {
+				// 1.0 and 1 belong in the same group
+				key += 'i' + std::to_string(static_cast<int64_t>(d)) + ';';
+			} else {
+				char bytes[sizeof(double)];
+				std::memcpy(bytes, &d, sizeof(double));
+				key += 'd';
+				key.append(bytes, sizeof(double));
+			}
+		} break;
+		case JsonNodeType::VALUE_BOOLEAN:
+			key += value.asBoolean() ? 't' : 'f';
+			break;
+		case JsonNodeType::VALUE_NULL:
+			key += 'n';
+			break;
+		default: {
+			std::string json;
+			{
+				JsonGenerator<std::string> generator(json, false);
+				value.write(generator);
+			}
+			key += 'j' + std::to_string(json.size()) + ':';
+			key += json;
+		} break;
+		}
+	}
+
+	static uint64_t hashBytes(uint64_t hash, const char* data, size_t size) {
+		for (size_t i = 0; i < size; ++i) {
+			hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	// Spreads FNV output over all 64 bits for the HyperLogLog
+	static uint64_t finalizeHash(uint64_t hash) {
+		hash ^= hash >> 33;
+		hash *= 0xff51afd7ed558ccdULL;
+		hash ^= hash >> 33;
+		hash *= 0xc4ceb9fe1a85ec53ULL;
+		hash ^= hash >> 33;
+		return hash;
+	}
+
+	template <class source>
+	void observe(JsonParser<source>& parser, size_t pattern) {
+		JsonToken token = parser.currentToken();
+		if (token == JsonToken::VALUE_NUMBER_INT) {
+			observe(pattern, token, parser.getIntegerValue(), parser.getDoubleValue(), nullptr);
+		} else if (token == JsonToken::VALUE_NUMBER_FLOAT) {
+			observe(pattern, token, 0, parser.getDoubleValue(), nullptr);
+		} else {
+			observe(pattern, token, 0, 0.0, token == JsonToken::VALUE_STRING ? &parser.getText() : nullptr);
+		}
+	}
+
+	// The same for a value that was already read
+	void observe(const JsonNode& node, size_t pattern) {
+		switch (node.getType()) {
+		case JsonNodeType::VALUE_NUMBER_INT:
+			observe(pattern, JsonToken::VALUE_NUMBER_INT, node.asInteger(), node.asDouble(), nullptr);
+			break;
+		case JsonNodeType::VALUE_NUMBER_FLOAT:
+			observe(pattern, JsonToken::VALUE_NUMBER_FLOAT, 0, node.asDouble(), nullptr);
+			break;
+		case JsonNodeType::VALUE_STRING:
+			observe(pattern, JsonToken::VALUE_STRING, 0, 0.0, &node.asString());
+			break;
+		case JsonNodeType::VALUE_BOOLEAN:
+			observe(pattern, node.asBoolean() ? JsonToken::VALUE_TRUE : JsonToken::VALUE_FALSE, 0, 0.0, nullptr);
+			break;
+		case JsonNodeType::VALUE_NULL:
+			observe(pattern, JsonToken::VALUE_NULL, 0, 0.0, nullptr);
+			break;
+		default:
+			observe(pattern, node.getType() == JsonNodeType::VALUE_OBJECT ? JsonToken::START_OBJECT : JsonToken::START_ARRAY, 0, 0.0, nullptr);
+			break;
+		}
+	}
+
+	// Numbers carry their values and strings their text
+	void observe(size_t pattern, JsonToken token, int64_t integer, double number, const std::string* text) {
+		for (size_t i = 0; i < metrics.size(); ++i) {
+			if (metrics[i].pattern != pattern) {
+				continue;
+			}
+			Observation observation;
+			observation.metric = i;
+			observation.token = token;
+			observation.integer = 0;
+			observation.number = 0.0;
+			observation.hash = 14695981039346656037ULL;
+			const JsonAggregateFunction function = metrics[i].function;
+			if (token == JsonToken::VALUE_NUMBER_INT || token == JsonToken::VALUE_NUMBER_FLOAT) {
+				observation.number = number;
+				observation.integer = integer;
+				// Hash by value so 1 and 1.0 are the same
+				double d = observation.number;
+				observation.hash = hashBytes(observation.hash ^ 'n', reinterpret_cast<const char*>(&d), sizeof(double));
+			} else if (function == JsonAggregateFunction::COUNT || function == JsonAggregateFunction::DISTINCT) {
+				if (token == JsonToken::VALUE_NULL || (function == JsonAggregateFunction::DISTINCT
+					&& (token == JsonToken::START_OBJECT || token == JsonToken::START_ARRAY))) {
+					continue;
+				}
+				if (token == JsonToken::VALUE_STRING) {
+					observation.hash = hashBytes(observation.hash ^ 's', text->data(), text->size());
+				} else {
+					observation.hash = hashBytes(observation.hash, reinterpret_cast<const char*>(&token), sizeof(token));
+				}
+			} else {
+				// Numeric aggregates ignore everything else
+				continue;
+			}
+			observation.hash = finalizeHash(observation.hash);
+			observations.push_back(observation);
+		}
+	}
+
+	// Visits the value at the parser's current token, leaving the parser on the
+	// token after it
+	template <class source>
+	void extract(JsonParser<source>& parser, size_t maxDepth) {
+		bool prefix = false;
+		JsonToken token = parser.currentToken();
+		const bool isContainer = token == JsonToken::START_OBJECT || token == JsonToken::START_ARRAY;
+		if (isContainer) {
+			// A container grouped on is read whole, and the other paths at or
+			// below it are taken from what was read
+			for (size_t i = 0; i < groupPaths.size(); ++i) {
+				if (groupValues[i].isNull() && (patterns[i].match(path) & JsonPath::FULL_MATCH)) {
+					groupValues[i].read(parser, maxDepth);
+					extract(groupValues[i], maxDepth);
+					return;
+				}
+			}
+		}
+		for (size_t i = 0; i < patterns.size(); ++i) {
+			if (i < groupPaths.size() && !groupValues[i].isNull()) {
+				continue;
+			}
+			int match = patterns[i].match(path);
+			if (match & JsonPath::FULL_MATCH) {
+				if (i < groupPaths.size()) {
+					readScalar(parser, groupValues[i]);
+				} else {
+					observe(parser, i);
+				}
+			}
+			prefix |= (match & JsonPath::PREFIX_MATCH) != 0;
+		}
+		if (!prefix || !isContainer) {
+			parser.fastSkipChildren();
+			parser.nextToken();
+			return;
+		}
+		if (maxDepth == 0) {
+			throw JsonException("Max depth exceeded while aggregating");
+		}
+		const bool isObject = token == JsonToken::START_OBJECT;
+		path.emplace_back();
+		path.back().isIndex = !isObject;
+		size_t index = 0;
+		token = parser.nextToken();
+		while (token != JsonToken::END_OBJECT && token != JsonToken::END_ARRAY) {
+			if (token == JsonToken::NOT_AVAILABLE) {
+				throw JsonException("Unexpected end of stream while aggregating");
+			}
+			if (isObject) {
+				path.back().name = parser.getCurrentName();
+			} else {
+				path.back().index = index++;
+			}
+			if (!isWanted()) {
+				if (isObject) {
+					parser.skipNextValue();
+				} else {
+					parser.fastSkipChildren();
+				}
+				parser.nextToken();
+			} else {
+				if (isObject) {
+					parser.nextToken();
+				}
+				extract(parser, maxDepth - 1);
+			}
+			token = parser.currentToken();
+		}
+		path.pop_back();
+		parser.nextToken();
+	}
+
+	// The same for a value that was already read
+	void extract(const JsonNode& node, size_t maxDepth) {
+		bool prefix = false;
+		for (size_t i = 0; i < patterns.size(); ++i) {
+			if (i < groupPaths.size() && !groupValues[i].isNull()) {
+				continue;
+			}
+			int match = patterns[i].match(path);
+			if (match & JsonPath::FULL_MATCH) {
+				if (i < groupPaths.size()) {
+					node.copyTo(groupValues[i], maxDepth);
+				} else {
+					observe(node, i);
+				}
+			}
+			prefix |= (match & JsonPath::PREFIX_MATCH) != 0;
+		}
+		const JsonNodeType type = node.getType();
+		if (!prefix || (type != JsonNodeType::VALUE_OBJECT && type != JsonNodeType::VALUE_ARRAY)) {
+			return;
+		}
+		if (maxDepth == 0) {
+			throw JsonException("Max depth exceeded while aggregating");
+		}
+		const bool isObject = type == JsonNodeType::VALUE_OBJECT;
+		path.emplace_back();
+		path.back().isIndex = !isObject;
+		for (size_t i = 0; i < node.size(); ++i) {
+			if (isObject) {
+				path.back().name = node.getField(i).first;
+			} else {
+				path.back().index = i;
+			}
+			if (isWanted()) {
+				extract(isObject ? node.getField(i).second : node[i], maxDepth - 1);
+			}
+		}
+		path.pop_back();
+	}
+
+	// Whether any path could match at or below the current location
+	bool isWanted() const {
+		for (size_t i = 0; i < patterns.size(); ++i) {
+			if (patterns[i].match(path) != 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	template <class source>
+	static void readScalar(JsonParser<source>& parser, JsonNode& node) {
+		switch (parser.currentToken()) {
+		case JsonToken::VALUE_STRING:
+			node.setString(parser.getText());
+			break;
+		case JsonToken::VALUE_NUMBER_INT:
+			node.setInteger(parser.getIntegerValue());
+			break;
+		case JsonToken::VALUE_NUMBER_FLOAT:
+			node.setDouble(parser.getDoubleValue());
+			break;
+		case JsonToken::VALUE_TRUE:
+		case JsonToken::VALUE_FALSE:
+			node.setBoolean(parser.currentToken() == JsonToken::VALUE_TRUE);
+			break;
+		default:
+			node.makeNull();
+			break;
+		}
+	}
+};
+}
+
+#endif
@@ -0,0 +1,199 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef JAXUP_BUILDER_H
+#define JAXUP_BUILDER_H
+
+#include <chrono>
+#include <vector>
+
+#include "jaxup_node.h"
+#include "jaxup_parser.h"
+
+namespace jaxup {
+
+// Reads a node a piece at a time, so that a large document can be built
+// between other work on the same thread.  Each call to step handles tokens
+// until roughly the given number of input bytes or amount of time has been
+// spent, and returns whether the node is complete.  Open containers are kept
+// on an explicit stack instead of the call stack, and the finished node and
+// the parser's position are the same as JsonNode::read would leave them.
+// Neither the parser nor the node may be used elsewhere until it's done.
+template <class source>
+class JsonNodeBuilder {
+public:
+	// Tokens handled between looking at the clock in timed steps
+	static const size_t tokensPerClockCheck = 64;
+
+	JsonNodeBuilder(JsonParser<source>& parser, JsonNode& root, size_t maxDepth = 50) : parser(parser), maxDepth(maxDepth) {
+		reset(root);
+	}
+
+	// Short string values are shared through the pool
+	JsonNodeBuilder(JsonParser<source>& parser, JsonNode& root, JsonStringPool& pool, size_t maxDepth = 50) : JsonNodeBuilder(parser, root, maxDepth) {
+		this->pool = &pool;
+	}
+
+	// Starts building another node from wherever the parser is now
+	void reset(JsonNode& newRoot) {
+		root = &newRoot;
+		root->makeNull();
+		field = nullptr;
+		stack.clear();
+		started = false;
+		done = false;
+	}
+
+	bool step(uint64_t byteBudget) {
+		uint64_t limit = parser.getCurrentByteOffset() + byteBudget;
+		while (!done) {
+			handleToken();
+			if (parser.getCurrentByteOffset() >= limit) {
+				break;
+			}
+		}
+		return done;
+	}
+
+	template <class Rep, class Period>
+	bool step(std::chrono::duration<Rep, Period> timeBudget) {
+		auto deadline = std::chrono::steady_clock::now() + timeBudget;
+		while (!done) {
+			for (size_t i = 0; i < tokensPerClockCheck && !done; ++i) {
+				handleToken();
+			}
+			if (std::chrono::steady_clock::now() >= deadline) {
+				break;
+			}
+		}
+		return done;
+	}
+
+	bool isDone() const {
+		return done;
+	}
+
+private:
+	JsonParser<source>& parser;
+	size_t maxDepth;
+	JsonStringPool* pool = nullptr;
+	JsonNode* root = nullptr;
+	// The value for the last field name read goes here
+	JsonNode* field = nullptr;
+	std::vector<JsonNode*> stack;
+	bool started = false;
+	bool done = false;
+
+	JsonNode& nextNode() {
+		if (stack.empty()) {
+			return *root;
+		}
+		if (stack.back()->getType() == JsonNodeType::VALUE_ARRAY) {
+			return stack.back()->append();
+		}
+		return *field;
+	}
+
+	void handleToken() {
+		JsonToken token = parser.currentToken();
+		if (!started) {
+			started = true;
+			if (token == JsonToken::NOT_AVAILABLE) {
+				// Give a kick start if the stream hasn't been read from
+				token = parser.nextToken();
+			}
+		}
+
+		switch (token) {
+		case JsonToken::VALUE_NUMBER_FLOAT:
+			nextNode().setDouble(parser.getDoubleValue());
+			break;
+		case JsonToken::VALUE_NUMBER_INT:
+			nextNode().setInteger(parser.getIntegerValue());
+			break;
+		case JsonToken::VALUE_NULL:
+			nextNode().makeNull();
+			break;
+		case JsonToken::VALUE_TRUE:
+			nextNode().setBoolean(true);
+			break;
+		case JsonToken::VALUE_FALSE:
+			nextNode().setBoolean(false);
+			break;
+		case JsonToken::VALUE_STRING:
+			if (pool != nullptr) {
+				nextNode().setString(parser.getText(), *pool);
+			} else {
+				nextNode().setString(parser.getText());
+			}
+			break;
+		case JsonToken::START_ARRAY: {
+			if (stack.size() >= maxDepth) {
+				throw JsonException("Max depth exceeded while parsing Array node");
+			}
+			JsonNode& node = nextNode();
+			node.makeArray();
+			stack.push_back(&node);
+			parser.nextToken();
+			return;
+		}
+		case JsonToken::START_OBJECT: {
+			if (stack.size() >= maxDepth) {
+				throw JsonException("Max depth exceeded while parsing Object node");
+			}
+			JsonNode& node = nextNode();
+			node.makeObject();
+			stack.push_back(&node);
+			parser.nextToken();
+			return;
+		}
+		case JsonToken::FIELD_NAME:
+			if (!stack.empty()) {
+				field = &stack.back()->append(parser.getCurrentName());
+				parser.nextToken();
+				return;
+			}
+			done = true;
+			return;
+		case JsonToken::END_ARRAY:
+		case JsonToken::END_OBJECT:
+			if (!stack.empty()) {
+				stack.pop_back();
+				break;
+			}
+			done = true;
+			return;
+		default:
+			// The input ended early, leaving whatever was read so far
+			done = true;
+			return;
+		}
+		parser.nextToken();
+		if (stack.empty()) {
+			done = true;
+		}
+	}
+};
+
+}
+
+#endif
@@ -0,0 +1,203 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+
+#ifndef JAXUP_CANONICAL_H
+#define JAXUP_CANONICAL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "jaxup_generator.h"
+#include "jaxup_node.h"
+
+namespace jaxup {
+
+// Incremental SHA-256 (FIPS 180-4)
+class JsonSha256 {
+public:
+	static const size_t digestSize = 32;
+
+	JsonSha256() {
+		reset();
+	}
+
+	void reset() {
+		static const uint32_t initial[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+			0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+		std::memcpy(state, initial, sizeof(state));
+		totalBytes = 0;
+		blockSize = 0;
+	}
+
+	void update(const char* data, size_t length) {
+		totalBytes += length;
+		if (blockSize > 0) {
+			size_t take = std::min(length, sizeof(block) - blockSize);
+			std::memcpy(block + blockSize, data, take);
+			blockSize += take;
+			data += take;
+			length -= take;
+			if (blockSize < sizeof(block)) {
+				return;
+			}
+			transform(block);
+			blockSize = 0;
+		}
+		while (length >= sizeof(block)) {
+			transform(reinterpret_cast<const unsigned char*>(data));
+			data += sizeof(block);
+			length -= sizeof(block);
+		}
+		std::memcpy(block, data, length);
+		blockSize = length;
+	}
+
+	// Finishes the hash and starts a new one
+	void digest(unsigned char out[digestSize]) {
+		const uint64_t totalBits = totalBytes * 8;
+		static const char padding[64] = {static_cast<char>(0x80)};
+		update(padding, 1 + (119 - blockSize) % 64);
+		char length[8];
+		for (int i = 0; i < 8; ++i) {
+			length[i] = static_cast<char>(totalBits >> (56 - 8 * i));
+		}
+		update(length, 8);
+		for (int i = 0; i < 8; ++i) {
+			out[4 * i] = static_cast<unsigned char>(state[i] >> 24);
+			out[4 * i + 1] = static_cast<unsigned char>(state[i] >> 16);
+			out[4 * i + 2] = static_cast<unsigned char>(state[i] >> 8);
+			out[4 * i + 3] = static_cast<unsigned char>(state[i]);
+		}
+		reset();
+	}
+
+	std::string hexDigest() {
+		static const char hex[] = "0123456789abcdef";
+		unsigned char out[digestSize];
+		digest(out);
+		std::string result(digestSize * 2, '0');
+		for (size_t i = 0; i < digestSize; ++i) {
+			result[2 * i] = hex[out[i] >> 4];
+			result[2 * i + 1] = hex[out[i] & 0xF];
+		}
+		return result;
+	}
+
+private:
+	uint32_t state[8];
+	unsigned char block[64];
+	size_t blockSize;
+	uint64_t totalBytes;
+
+	static inline uint32_t rotate(uint32_t x, int n) {
+		return (x >> n) | (x << (32 - n));
+	}
+
+	void transform(const unsigned char* data) {
+		static const uint32_t k[64] = {
+			0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+			0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+			0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+			0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+			0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+			0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+			0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+			0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+		uint32_t w[64];
+		for (int i = 0; i < 16; ++i) {
+			w[i] = (uint32_t(data[4 * i]) << 24) | (uint32_t(data[4 * i + 1]) << 16)
+				| (uint32_t(data[4 * i + 2]) << 8) | uint32_t(data[4 * i + 3]);
+		}
+		for (int i = 16; i < 64; ++i) {
+			uint32_t s0 = rotate(w[i - 15], 7) ^ rotate(w[i - 15], 18) ^ (w[i - 15] >> 3);
+			uint32_t s1 = rotate(w[i - 2], 17) ^ rotate(w[i - 2], 19) ^ (w[i - 2] >> 10);
+			w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+		}
+		uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+		uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+		for (int i = 0; i < 64; ++i) {
+			uint32_t t1 = h + (rotate(e, 6) ^ rotate(e, 11) ^ rotate(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+			uint32_t t2 = (rotate(a, 2) ^ rotate(a, 13) ^ rotate(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+			h = g;
+			g = f;
+			f = e;
+			e = d + t1;
+			d = c;
+			c = b;
+			b = a;
+			a = t1 + t2;
+		}
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+		state[5] += f;
+		state[6] += g;
+		state[7] += h;
+	}
+};
+
+// Lets a generator hash its output without keeping it
+template <size_t size>
+class JsonDestination<JsonSha256, size> {
+public:
+	JsonDestination(JsonSha256& output) : output(&output) {
+	}
+	inline void reset(JsonSha256& newOutput) {
+		output = &newOutput;
+	}
+	inline void write(char bytes[size], size_t count) {
+		output->update(bytes, count);
+	}
+
+private:
+	JsonSha256* output;
+};
+
+inline std::string toCanonicalJson(const JsonNode& node, size_t maxDepth = 50) {
+	std::string result;
+	JsonGenerator<std::string> generator(result, false);
+	generator.setCanonical(true);
+	node.write(generator, maxDepth);
+	generator.flush();
+	return result;
+}
+
+// Hex encoded SHA-256 of the node's canonical form
+inline std::string getCanonicalSha256(const JsonNode& node, size_t maxDepth = 50) {
+	JsonSha256 hash;
+	{
+		JsonGenerator<JsonSha256> generator(hash, false);
+		generator.setCanonical(true);
+		node.write(generator, maxDepth);
+		generator.flush();
+	}
+	return hash.hexDigest();
+}
+}
+
+#endif
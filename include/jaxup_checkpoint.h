@@ -0,0 +1,94 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#ifndef JAXUP_CHECKPOINT_H
+#define JAXUP_CHECKPOINT_H
+
+#include <string>
+
+#include "jaxup_common.h"
+#include "jaxup_generator.h"
+#include "jaxup_node.h"
+#include "jaxup_parser.h"
+
+namespace jaxup {
+
+// Parser checkpoints are themselves stored as small JSON objects, e.g.
+// {"offset":1234,"tokenOffset":1230,"token":"String","stack":"[{","name":"id","text":"abc","integer":0,"double":0.0}
+
+static inline JsonToken getTokenFromString(const std::string& name) {
+	for (int t = static_cast<int>(JsonToken::NOT_AVAILABLE); t <= static_cast<int>(JsonToken::VALUE_NULL); ++t) {
+		if (getTokenAsString(static_cast<JsonToken>(t)) == name) {
+			return static_cast<JsonToken>(t);
+		}
+	}
+	throw JsonException("Unknown token type: ", name);
+}
+
+template <class dest>
+void writeParserState(JsonGenerator<dest>& generator, const JsonParserState& state) {
+	std::string stack;
+	stack.reserve(state.tagStack.size());
+	for (JsonToken t : state.tagStack) {
+		stack.push_back(t == JsonToken::START_OBJECT ? '{' : '[');
+	}
+	generator.startObject();
+	generator.writeField("offset", static_cast<int64_t>(state.byteOffset));
+	generator.writeField("tokenOffset", static_cast<int64_t>(state.tokenByteOffset));
+	generator.writeField("token", getTokenAsString(state.token));
+	generator.writeField("stack", stack);
+	generator.writeField("name", state.currentName);
+	generator.writeField("text", state.currentString);
+	generator.writeField("integer", state.integerValue);
+	generator.writeField("double", state.doubleValue);
+	generator.endObject();
+}
+
+template <class source>
+void readParserState(JsonParser<source>& parser, JsonParserState& state) {
+	JsonNode node;
+	node.read(parser, 2);
+	if (node.getType() != JsonNodeType::VALUE_OBJECT) {
+		throw JsonException("Expected a parser checkpoint object");
+	}
+	state.byteOffset = static_cast<uint64_t>(node.getInteger("offset"));
+	state.tokenByteOffset = static_cast<uint64_t>(node.getInteger("tokenOffset", 0));
+	state.token = getTokenFromString(node.getString("token"));
+	state.tagStack.clear();
+	for (char c : node.getString("stack")) {
+		if (c == '{') {
+			state.tagStack.push_back(JsonToken::START_OBJECT);
+		} else if (c == '[') {
+			state.tagStack.push_back(JsonToken::START_ARRAY);
+		} else {
+			throw JsonException("Invalid parser checkpoint stack");
+		}
+	}
+	state.currentName = node.getString("name", "");
+	state.currentString = node.getString("text", "");
+	state.integerValue = node.getInteger("integer", 0);
+	state.doubleValue = node.getDouble("double", 0.0);
+}
+}
+
+#endif
@@ -0,0 +1,547 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef JAXUP_COMPACT_H
+#define JAXUP_COMPACT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "jaxup_generator.h"
+#include "jaxup_node.h"
+#include "jaxup_parser.h"
+
+namespace jaxup {
+
+enum class CompactJsonOrder {
+	// Every level of the tree follows the one above it
+	BREADTH_FIRST,
+	// Every subtree follows its parent's children
+	DEPTH_FIRST
+};
+
+// A read-only copy of a tree laid out in one block of 16 byte entries, with
+// the children of each container next to each other and addressed by
+// index.  Strings and field names live in a second block.  Scans over the
+// whole tree walk memory in order rather than chasing a pointer per
+// container, which makes hashing and writing large trees faster.
+class CompactJsonDocument {
+private:
+	struct Entry {
+		JsonNodeType type;
+		// Offset of the field name in strings, if the parent is an object
+		uint32_t name;
+		union {
+			int64_t i;
+			double d;
+			bool b;
+			uint32_t string;
+			struct {
+				uint32_t first;
+				uint32_t count;
+			} children;
+		} value;
+	};
+
+public:
+	// Refers to a node in a document, and is only valid while the document is
+	// unchanged
+	class Node {
+	public:
+		JsonNodeType getType() const {
+			return entry->type;
+		}
+
+		inline bool isNull() const {
+			return entry->type == JsonNodeType::VALUE_NULL;
+		}
+
+		inline bool isNumeric() const {
+			return entry->type == JsonNodeType::VALUE_NUMBER_INT || entry->type == JsonNodeType::VALUE_NUMBER_FLOAT;
+		}
+
+		int64_t asInteger() const {
+			if (entry->type == JsonNodeType::VALUE_NUMBER_INT) {
+				return entry->value.i;
+			} else if (entry->type == JsonNodeType::VALUE_NUMBER_FLOAT) {
+				return static_cast<int64_t>(entry->value.d);
+			}
+			throw JsonException("Attempted to read JSON ", getNodeTypeAsString(entry->type), " node as an Integer");
+		}
+
+		double asDouble() const {
+			if (entry->type == JsonNodeType::VALUE_NUMBER_FLOAT) {
+				return entry->value.d;
+			} else if (entry->type == JsonNodeType::VALUE_NUMBER_INT) {
+				return static_cast<double>(entry->value.i);
+			}
+			throw JsonException("Attempted to read JSON ", getNodeTypeAsString(entry->type), " node as a Double");
+		}
+
+		bool asBoolean() const {
+			if (entry->type == JsonNodeType::VALUE_BOOLEAN) {
+				return entry->value.b;
+			}
+			throw JsonException("Attempted to read JSON ", getNodeTypeAsString(entry->type), " node as a Boolean");
+		}
+
+		std::string asString() const {
+			if (entry->type == JsonNodeType::VALUE_STRING) {
+				size_t length;
+				const char* data = doc->getString(entry->value.string, length);
+				return std::string(data, length);
+			}
+			throw JsonException("Attempted to read JSON ", getNodeTypeAsString(entry->type), " node as a String");
+		}
+
+		size_t size() const {
+			if (entry->type == JsonNodeType::VALUE_ARRAY || entry->type == JsonNodeType::VALUE_OBJECT) {
+				return entry->value.children.count;
+			}
+			return 0;
+		}
+
+		Node operator[](size_t n) const {
+			if (entry->type != JsonNodeType::VALUE_ARRAY && entry->type != JsonNodeType::VALUE_OBJECT) {
+				throw JsonException("Attempted to index into JSON ", getNodeTypeAsString(entry->type), " node");
+			}
+			if (n >= entry->value.children.count) {
+				throw JsonException("Index out of bounds");
+			}
+			return Node(doc, &doc->entries[entry->value.children.first + n]);
+		}
+
+		// Returns a null node if there is no such field
+		Node operator[](const std::string& key) const {
+			if (entry->type == JsonNodeType::VALUE_OBJECT) {
+				const Entry* child = doc->entries.data() + entry->value.children.first;
+				const Entry* end = child + entry->value.children.count;
+				for (; child != end; ++child) {
+					size_t length;
+					const char* data = doc->getString(child->name, length);
+					if (length == key.size() && std::memcmp(data, key.data(), length) == 0) {
+						return Node(doc, child);
+					}
+				}
+			}
+			return Node(doc, &nullEntry());
+		}
+
+		std::string getFieldName(size_t n) const {
+			if (entry->type != JsonNodeType::VALUE_OBJECT) {
+				throw JsonException("Attempted to read a field name from JSON ", getNodeTypeAsString(entry->type), " node");
+			}
+			size_t length;
+			const char* data = doc->getString((*this)[n].entry->name, length);
+			return std::string(data, length);
+		}
+
+		// Agrees with JsonNode::hash for the same tree
+		uint64_t hash(size_t maxDepth = 50) const {
+			return doc->hash(*entry, maxDepth);
+		}
+
+		template <class dest>
+		void write(JsonGenerator<dest>& generator, size_t maxDepth = 50) const {
+			doc->write(*entry, generator, maxDepth);
+		}
+
+		void expand(JsonNode& node, size_t maxDepth = 50) const {
+			doc->expand(*entry, node, maxDepth);
+		}
+
+	private:
+		friend class CompactJsonDocument;
+
+		Node(const CompactJsonDocument* doc, const Entry* entry) : doc(doc), entry(entry) {
+		}
+
+		const CompactJsonDocument* doc;
+		const Entry* entry;
+	};
+
+	CompactJsonDocument() {
+		clear();
+	}
+
+	explicit CompactJsonDocument(const JsonNode& root, CompactJsonOrder order = CompactJsonOrder::BREADTH_FIRST, size_t maxDepth = 50) {
+		compact(root, order, maxDepth);
+	}
+
+	// Replaces the document with a copy of the tree
+	void compact(const JsonNode& root, CompactJsonOrder order = CompactJsonOrder::BREADTH_FIRST, size_t maxDepth = 50) {
+		entries.clear();
+		strings.clear();
+		size_t numEntries = 1;
+		size_t numBytes = 0;
+		measure(root, numEntries, numBytes, maxDepth);
+		entries.reserve(numEntries);
+		strings.reserve(numBytes);
+		entries.push_back(nullEntry());
+		place(root, 0);
+		if (order == CompactJsonOrder::BREADTH_FIRST) {
+			placeBreadthFirst(root, maxDepth);
+		} else {
+			placeDepthFirst(root, 0, maxDepth);
+		}
+	}
+
+	template <class source>
+	void read(JsonParser<source>& parser, CompactJsonOrder order = CompactJsonOrder::BREADTH_FIRST, size_t maxDepth = 50) {
+		JsonNode node;
+		node.read(parser, maxDepth);
+		compact(node, order, maxDepth);
+	}
+
+	void clear() {
+		entries.assign(1, nullEntry());
+		strings.clear();
+	}
+
+	Node root() const {
+		return Node(this, &entries[0]);
+	}
+
+	size_t getNodeCount() const {
+		return entries.size();
+	}
+
+	// Bytes held by the document's two blocks
+	size_t getByteSize() const {
+		return entries.size() * sizeof(Entry) + strings.size();
+	}
+
+private:
+	std::vector<Entry> entries;
+	// Each string is its length as four bytes followed by its bytes
+	std::string strings;
+
+	static const Entry& nullEntry() {
+		static const Entry entry = {JsonNodeType::VALUE_NULL, 0, {0}};
+		return entry;
+	}
+
+	uint32_t addString(const std::string& value) {
+		if (strings.size() + value.size() + sizeof(uint32_t) > UINT32_MAX) {
+			throw JsonException("Too much string data to compact");
+		}
+		uint32_t offset = static_cast<uint32_t>(strings.size());
+		uint32_t length = static_cast<uint32_t>(value.size());
+		strings.append(reinterpret_cast<const char*>(&length), sizeof(length));
+		strings.append(value);
+		return offset;
+	}
+
+	const char* getString(uint32_t offset, size_t& length) const {
+		uint32_t stored;
+		std::memcpy(&stored, strings.data() + offset, sizeof(stored));
+		length = stored;
+		return strings.data() + offset + sizeof(stored);
+	}
+
+	// Counts what the tree will need so that both blocks are allocated once
+	static void measure(const JsonNode& node, size_t& numEntries, size_t& numBytes, size_t maxDepth) {
+		switch (node.getType()) {
+		case JsonNodeType::VALUE_STRING:
+			numBytes += sizeof(uint32_t) + node.asString().size();
+			break;
+		case JsonNodeType::VALUE_ARRAY:
+			if (maxDepth == 0) {
+				throw JsonException("Max depth exceeded while compacting node");
+			}
+			numEntries += node.size();
+			for (size_t i = 0; i < node.size(); ++i) {
+				measure(node[i], numEntries, numBytes, maxDepth - 1);
+			}
+			break;
+		case JsonNodeType::VALUE_OBJECT:
+			if (maxDepth == 0) {
+				throw JsonException("Max depth exceeded while compacting node");
+			}
+			numEntries += node.size();
+			for (size_t i = 0; i < node.size(); ++i) {
+				auto field = node.getField(i);
+				numBytes += sizeof(uint32_t) + field.first.size();
+				measure(field.second, numEntries, numBytes, maxDepth - 1);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	// Fills in everything but the range of children
+	void place(const JsonNode& node, size_t index) {
+		Entry& entry = entries[index];
+		entry.type = node.getType();
+		switch (entry.type) {
+		case JsonNodeType::VALUE_NUMBER_INT:
+			entry.value.i = node.asInteger();
+			break;
+		case JsonNodeType::VALUE_NUMBER_FLOAT:
+			entry.value.d = node.asDouble();
+			break;
+		case JsonNodeType::VALUE_BOOLEAN:
+			entry.value.b = node.asBoolean();
+			break;
+		case JsonNodeType::VALUE_STRING:
+			entry.value.string = addString(node.asString());
+			break;
+		default:
+			entry.value.children.first = 0;
+			entry.value.children.count = 0;
+			break;
+		}
+	}
+
+	// Appends the node's children next to each other
+	void placeChildren(const JsonNode& node, size_t index) {
+		size_t count = node.size();
+		if (entries.size() + count > UINT32_MAX) {
+			throw JsonException("Too many nodes to compact");
+		}
+		size_t first = entries.size();
+		entries[index].value.children.first = static_cast<uint32_t>(first);
+		entries[index].value.children.count = static_cast<uint32_t>(count);
+		entries.resize(first + count, nullEntry());
+		if (node.getType() == JsonNodeType::VALUE_ARRAY) {
+			for (size_t i = 0; i < count; ++i) {
+				place(node[i], first + i);
+			}
+		} else {
+			for (size_t i = 0; i < count; ++i) {
+				auto field = node.getField(i);
+				place(field.second, first + i);
+				entries[first + i].name = addString(field.first);
+			}
+		}
+	}
+
+	static bool isContainer(const JsonNode& node) {
+		return node.getType() == JsonNodeType::VALUE_ARRAY || node.getType() == JsonNodeType::VALUE_OBJECT;
+	}
+
+	void placeBreadthFirst(const JsonNode& root, size_t maxDepth) {
+		struct Pending {
+			const JsonNode* node;
+			size_t index;
+			size_t depth;
+		};
+		std::deque<Pending> queue;
+		if (isContainer(root)) {
+			queue.push_back({&root, 0, 0});
+		}
+		while (!queue.empty()) {
+			Pending pending = queue.front();
+			queue.pop_front();
+			if (pending.depth == maxDepth) {
+				throw JsonException("Max depth exceeded while compacting node");
+			}
+			placeChildren(*pending.node, pending.index);
+			size_t first = entries[pending.index].value.children.first;
+			for (size_t i = 0; i < pending.node->size(); ++i) {
+				const JsonNode& child = pending.node->getType() == JsonNodeType::VALUE_ARRAY ? (*pending.node)[i] : pending.node->getField(i).second;
+				if (isContainer(child)) {
+					queue.push_back({&child, first + i, pending.depth + 1});
+				}
+			}
+		}
+	}
+
+	void placeDepthFirst(const JsonNode& node, size_t index, size_t maxDepth) {
+		if (!isContainer(node)) {
+			return;
+		}
+		if (maxDepth == 0) {
+			throw JsonException("Max depth exceeded while compacting node");
+		}
+		placeChildren(node, index);
+		size_t first = entries[index].value.children.first;
+		for (size_t i = 0; i < node.size(); ++i) {
+			const JsonNode& child = node.getType() == JsonNodeType::VALUE_ARRAY ? node[i] : node.getField(i).second;
+			placeDepthFirst(child, first + i, maxDepth - 1);
+		}
+	}
+
+	uint64_t hash(const Entry& entry, size_t maxDepth) const {
+		uint64_t hash = static_cast<uint64_t>(entry.type);
+		switch (entry.type) {
+		case JsonNodeType::VALUE_NUMBER_INT:
+		case JsonNodeType::VALUE_NUMBER_FLOAT: {
+			// Hash by value so 1 and 1.0 agree
+			double d = entry.type == JsonNodeType::VALUE_NUMBER_INT ? static_cast<double>(entry.value.i) : entry.value.d;
+			uint64_t bits;
+			std::memcpy(&bits, &d, sizeof(bits));
+			hash = JsonNode::hashMix(static_cast<uint64_t>(JsonNodeType::VALUE_NUMBER_FLOAT), d == 0.0 ? 0 : bits);
+		} break;
+		case JsonNodeType::VALUE_BOOLEAN:
+			hash = JsonNode::hashMix(hash, entry.value.b);
+			break;
+		case JsonNodeType::VALUE_STRING: {
+			size_t length;
+			const char* data = getString(entry.value.string, length);
+			hash = JsonNode::hashString(data, length);
+		} break;
+		case JsonNodeType::VALUE_ARRAY: {
+			if (maxDepth == 0) {
+				throw JsonException("Max depth exceeded while hashing Array node");
+			}
+			const Entry* child = entries.data() + entry.value.children.first;
+			for (const Entry* end = child + entry.value.children.count; child != end; ++child) {
+				hash = JsonNode::hashMix(hash, this->hash(*child, maxDepth - 1));
+			}
+		} break;
+		case JsonNodeType::VALUE_OBJECT: {
+			if (maxDepth == 0) {
+				throw JsonException("Max depth exceeded while hashing Object node");
+			}
+			// Summed so that key order does not matter
+			uint64_t sum = 0;
+			const Entry* child = entries.data() + entry.value.children.first;
+			for (const Entry* end = child + entry.value.children.count; child != end; ++child) {
+				size_t length;
+				const char* data = getString(child->name, length);
+				sum += JsonNode::hashFinalize(JsonNode::hashMix(JsonNode::hashString(data, length), this->hash(*child, maxDepth - 1)));
+			}
+			hash = JsonNode::hashMix(hash, sum);
+		} break;
+		default:
+			break;
+		}
+		return JsonNode::hashFinalize(hash);
+	}
+
+	template <class dest>
+	void write(const Entry& entry, JsonGenerator<dest>& generator, size_t maxDepth) const {
+		switch (entry.type) {
+		case JsonNodeType::VALUE_NUMBER_FLOAT:
+			generator.write(entry.value.d);
+			break;
+		case JsonNodeType::VALUE_NUMBER_INT:
+			generator.write(entry.value.i);
+			break;
+		case JsonNodeType::VALUE_NULL:
+			generator.write(nullptr);
+			break;
+		case JsonNodeType::VALUE_BOOLEAN:
+			generator.write(entry.value.b);
+			break;
+		case JsonNodeType::VALUE_STRING: {
+			size_t length;
+			const char* data = getString(entry.value.string, length);
+			generator.write(data, length);
+		} break;
+		case JsonNodeType::VALUE_ARRAY: {
+			if (maxDepth == 0) {
+				throw JsonException("Max depth exceeded while writing Array node");
+			}
+			generator.startArray();
+			const Entry* child = entries.data() + entry.value.children.first;
+			for (const Entry* end = child + entry.value.children.count; child != end; ++child) {
+				write(*child, generator, maxDepth - 1);
+			}
+			generator.endArray();
+		} break;
+		case JsonNodeType::VALUE_OBJECT: {
+			if (maxDepth == 0) {
+				throw JsonException("Max depth exceeded while writing Object node");
+			}
+			generator.startObject();
+			std::vector<const Entry*> fields;
+			fields.reserve(entry.value.children.count);
+			const Entry* child = entries.data() + entry.value.children.first;
+			for (const Entry* end = child + entry.value.children.count; child != end; ++child) {
+				fields.push_back(child);
+			}
+			if (generator.isCanonical()) {
+				std::sort(fields.begin(), fields.end(), [this](const Entry* a, const Entry* b) {
+					size_t aLength, bLength;
+					const char* aData = getString(a->name, aLength);
+					const char* bData = getString(b->name, bLength);
+					return compareUtf16(aData, aLength, bData, bLength) < 0;
+				});
+			}
+			for (const Entry* field : fields) {
+				size_t length;
+				const char* data = getString(field->name, length);
+				generator.writeFieldName(data, length);
+				write(*field, generator, maxDepth - 1);
+			}
+			generator.endObject();
+		} break;
+		}
+	}
+
+	void expand(const Entry& entry, JsonNode& node, size_t maxDepth) const {
+		switch (entry.type) {
+		case JsonNodeType::VALUE_NUMBER_FLOAT:
+			node.setDouble(entry.value.d);
+			break;
+		case JsonNodeType::VALUE_NUMBER_INT:
+			node.setInteger(entry.value.i);
+			break;
+		case JsonNodeType::VALUE_NULL:
+			node.makeNull();
+			break;
+		case JsonNodeType::VALUE_BOOLEAN:
+			node.setBoolean(entry.value.b);
+			break;
+		case JsonNodeType::VALUE_STRING: {
+			size_t length;
+			const char* data = getString(entry.value.string, length);
+			node.setString(data, length);
+		} break;
+		case JsonNodeType::VALUE_ARRAY:
+		case JsonNodeType::VALUE_OBJECT: {
+			if (maxDepth == 0) {
+				throw JsonException("Max depth exceeded while expanding node");
+			}
+			node.makeNull();
+			if (entry.type == JsonNodeType::VALUE_ARRAY) {
+				node.makeArray();
+			} else {
+				node.makeObject();
+			}
+			node.reserve(entry.value.children.count);
+			const Entry* child = entries.data() + entry.value.children.first;
+			for (const Entry* end = child + entry.value.children.count; child != end; ++child) {
+				if (entry.type == JsonNodeType::VALUE_ARRAY) {
+					expand(*child, node.append(), maxDepth - 1);
+				} else {
+					size_t length;
+					const char* data = getString(child->name, length);
+					expand(*child, node.append(std::string(data, length)), maxDepth - 1);
+				}
+			}
+		} break;
+		}
+	}
+};
+
+}
+
+#endif
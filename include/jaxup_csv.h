@@ -0,0 +1,352 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+
+#ifndef JAXUP_CSV_H
+#define JAXUP_CSV_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "jaxup_common.h"
+#include "jaxup_generator.h"
+#include "jaxup_ndjson.h"
+#include "jaxup_numeric.h"
+#include "jaxup_parser.h"
+#include "jaxup_path.h"
+#include "jaxup_thread_pool.h"
+
+namespace jaxup {
+
+// Converts records to CSV (RFC 4180) or TSV rows, one column per path.  Only
+// the first value matching each path is used, missing values and nulls are
+// left empty, and objects and arrays are written as compact JSON.  Fields that
+// no remaining column needs are skipped without being converted.
+class JsonCsvWriter {
+public:
+	// Adds a column for the values at path, headed by name or, if that is
+	// empty, by the path itself
+	JsonCsvWriter& addColumn(const std::string& path, const std::string& name = "") {
+		patterns.emplace_back(path);
+		names.push_back(name.empty() ? path : name);
+		return *this;
+	}
+
+	JsonCsvWriter& setDelimiter(char newDelimiter) {
+		delimiter = newDelimiter;
+		return *this;
+	}
+
+	// "\n" by default, RFC 4180 asks for "\r\n"
+	JsonCsvWriter& setLineTerminator(const std::string& terminator) {
+		lineTerminator = terminator;
+		return *this;
+	}
+
+	// Treat top level arrays as sequences of records rather than as records
+	JsonCsvWriter& setUnwrapArrays(bool unwrap) {
+		unwrapArrays = unwrap;
+		return *this;
+	}
+
+	size_t numColumns() const {
+		return patterns.size();
+	}
+
+	void writeHeader(std::string& output) const {
+		for (size_t i = 0; i < names.size(); ++i) {
+			if (i > 0) {
+				output += delimiter;
+			}
+			writeCell(output, names[i]);
+		}
+		output += lineTerminator;
+	}
+
+	// Appends a row for every record in the stream.  Returns the number of
+	// rows written.
+	template <class source>
+	uint64_t convert(JsonParser<source>& parser, std::string& output, size_t maxDepth = 50) {
+		return convertAll(parser, output, nullptr, maxDepth);
+	}
+
+	// Like above, but writes to a file whenever enough rows have built up
+	template <class source>
+	uint64_t convert(JsonParser<source>& parser, FILE* output, size_t maxDepth = 50) {
+		std::string rows;
+		return convertAll(parser, rows, output, maxDepth);
+	}
+
+	// Converts newline delimited records on a thread pool, writing rows in
+	// input order.  Returns the number of rows written.
+	uint64_t convert(FILE* input, FILE* output, JsonThreadPool& pool, size_t maxDepth = 50) {
+		std::vector<JsonCsvWriter> workers(pool.size(), *this);
+		std::vector<uint64_t> counts(pool.size(), 0);
+		JsonNdjsonProcessor processor(pool);
+		processor.process(input, output, [&](JsonParser<std::string>& parser, std::string& rows) {
+			size_t worker = JsonThreadPool::currentWorker();
+			counts[worker] += workers[worker].convert(parser, rows, maxDepth);
+		});
+		uint64_t count = 0;
+		for (uint64_t c : counts) {
+			count += c;
+		}
+		return count;
+	}
+
+	// Appends a row for the record at the parser's current token, leaving the
+	// parser on the token after it
+	template <class source>
+	void convertValue(JsonParser<source>& parser, std::string& output, size_t maxDepth = 50) {
+		cells.resize(patterns.size());
+		filled.assign(patterns.size(), false);
+		remaining = patterns.size();
+		path.clear();
+		extract(parser, maxDepth);
+		for (size_t i = 0; i < cells.size(); ++i) {
+			if (i > 0) {
+				output += delimiter;
+			}
+			if (filled[i]) {
+				writeCell(output, cells[i]);
+			}
+		}
+		output += lineTerminator;
+	}
+
+private:
+	static const size_t noColumn = static_cast<size_t>(-1);
+
+	std::vector<JsonPath> patterns;
+	std::vector<std::string> names;
+	char delimiter = ',';
+	std::string lineTerminator = "\n";
+	bool unwrapArrays = false;
+
+	// Per record state
+	std::vector<std::string> cells;
+	std::vector<bool> filled;
+	size_t remaining = 0;
+	std::vector<JsonPathElement> path;
+
+	static void writeFile(FILE* output, const std::string& data) {
+		if (fwrite(data.data(), 1, data.size(), output) != data.size()) {
+			throw JsonException("Failed to write output");
+		}
+	}
+
+	// Appends rows to the string, moving them to the file, if any, whenever
+	// enough have built up
+	template <class source>
+	uint64_t convertAll(JsonParser<source>& parser, std::string& rows, FILE* file, size_t maxDepth) {
+		const size_t flushSize = 1 << 20;
+		uint64_t count = 0;
+		if (parser.currentToken() == JsonToken::NOT_AVAILABLE) {
+			parser.nextToken();
+		}
+		while (parser.currentToken() != JsonToken::NOT_AVAILABLE) {
+			if (unwrapArrays && parser.currentToken() == JsonToken::START_ARRAY) {
+				parser.nextToken();
+				while (parser.currentToken() != JsonToken::END_ARRAY) {
+					if (parser.currentToken() == JsonToken::NOT_AVAILABLE) {
+						throw JsonException("Unexpected end of stream while converting to CSV");
+					}
+					convertValue(parser, rows, maxDepth);
+					++count;
+					if (file != nullptr && rows.size() >= flushSize) {
+						writeFile(file, rows);
+						rows.clear();
+					}
+				}
+				parser.nextToken();
+				continue;
+			}
+			convertValue(parser, rows, maxDepth);
+			++count;
+			if (file != nullptr && rows.size() >= flushSize) {
+				writeFile(file, rows);
+				rows.clear();
+			}
+		}
+		if (file != nullptr) {
+			writeFile(file, rows);
+			rows.clear();
+		}
+		return count;
+	}
+
+	// Quotes the cell only if it holds a delimiter, quote or line break
+	void writeCell(std::string& output, const std::string& cell) const {
+		bool needsQuotes = false;
+		for (char c : cell) {
+			if (c == delimiter || c == '"' || c == '\n' || c == '\r') {
+				needsQuotes = true;
+				break;
+			}
+		}
+		if (!needsQuotes) {
+			output += cell;
+			return;
+		}
+		output += '"';
+		size_t runStart = 0;
+		for (size_t i = 0; i < cell.size(); ++i) {
+			if (cell[i] == '"') {
+				output.append(cell, runStart, i + 1 - runStart);
+				output += '"';
+				runStart = i + 1;
+			}
+		}
+		output.append(cell, runStart, std::string::npos);
+		output += '"';
+	}
+
+	template <class source>
+	void readCell(JsonParser<source>& parser, std::string& cell) {
+		char buff[36];
+		switch (parser.currentToken()) {
+		case JsonToken::VALUE_STRING:
+			cell = parser.getText();
+			break;
+		case JsonToken::VALUE_NUMBER_INT: {
+			char* start = numeric::writeIntegerToBuff(parser.getIntegerValue(), buff + sizeof(buff));
+			cell.assign(start, buff + sizeof(buff) - start);
+		} break;
+		case JsonToken::VALUE_NUMBER_FLOAT: {
+			int len = numeric::ryu(parser.getDoubleValue(), buff);
+			if (len < 0) {
+				throw JsonException("Failed to serialize double");
+			}
+			cell.assign(buff, len);
+		} break;
+		case JsonToken::VALUE_TRUE:
+			cell = "true";
+			break;
+		case JsonToken::VALUE_FALSE:
+			cell = "false";
+			break;
+		case JsonToken::START_OBJECT:
+		case JsonToken::START_ARRAY: {
+			cell.clear();
+			JsonGenerator<std::string> generator(cell, false);
+			generator.copyCurrentStructure(parser);
+		} break;
+		default:
+			cell.clear();
+		}
+	}
+
+	// Fills the columns that match the value at the parser's current token,
+	// leaving the parser on the token after it
+	template <class source>
+	void extract(JsonParser<source>& parser, size_t maxDepth) {
+		bool prefix = false;
+		JsonToken token = parser.currentToken();
+		const bool isContainer = token == JsonToken::START_OBJECT || token == JsonToken::START_ARRAY;
+		size_t read = noColumn;
+		for (size_t i = 0; i < patterns.size(); ++i) {
+			if (filled[i]) {
+				continue;
+			}
+			int match = patterns[i].match(path);
+			if ((match & JsonPath::FULL_MATCH) && token != JsonToken::VALUE_NULL) {
+				if (read == noColumn) {
+					readCell(parser, cells[i]);
+					read = i;
+				} else {
+					cells[i] = cells[read];
+				}
+				filled[i] = true;
+				--remaining;
+				continue;
+			}
+			prefix |= (match & JsonPath::PREFIX_MATCH) != 0;
+		}
+		if (read != noColumn && isContainer) {
+			// The container was consumed whole, so any column below it is
+			// found by parsing the copy
+			parser.nextToken();
+			if (prefix) {
+				std::string copy = cells[read];
+				JsonParser<std::string> copyParser(copy);
+				copyParser.nextToken();
+				extract(copyParser, maxDepth);
+			}
+			return;
+		}
+		if (!prefix || !isContainer) {
+			parser.fastSkipChildren();
+			parser.nextToken();
+			return;
+		}
+		if (maxDepth == 0) {
+			throw JsonException("Max depth exceeded while converting to CSV");
+		}
+		const bool isObject = token == JsonToken::START_OBJECT;
+		path.emplace_back();
+		path.back().isIndex = !isObject;
+		size_t index = 0;
+		token = parser.nextToken();
+		while (token != JsonToken::END_OBJECT && token != JsonToken::END_ARRAY) {
+			if (token == JsonToken::NOT_AVAILABLE) {
+				throw JsonException("Unexpected end of stream while converting to CSV");
+			}
+			if (isObject) {
+				path.back().name = parser.getCurrentName();
+			} else {
+				path.back().index = index++;
+			}
+			if (remaining == 0 || !isWanted()) {
+				if (isObject) {
+					parser.skipNextValue();
+				} else {
+					parser.fastSkipChildren();
+				}
+				parser.nextToken();
+			} else {
+				if (isObject) {
+					parser.nextToken();
+				}
+				extract(parser, maxDepth - 1);
+			}
+			token = parser.currentToken();
+		}
+		path.pop_back();
+		parser.nextToken();
+	}
+
+	// Whether any unfilled column could match at or below the current location
+	bool isWanted() const {
+		for (size_t i = 0; i < patterns.size(); ++i) {
+			if (!filled[i] && patterns[i].match(path) != 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+};
+}
+
+#endif
@@ -0,0 +1,170 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#ifndef JAXUP_FILTER_H
+#define JAXUP_FILTER_H
+
+#include <string>
+#include <vector>
+
+#include "jaxup_common.h"
+#include "jaxup_generator.h"
+#include "jaxup_parser.h"
+#include "jaxup_path.h"
+
+namespace jaxup {
+
+// Copies documents from a parser to a generator, keeping or dropping values by
+// location.  With no include patterns everything is kept, otherwise only values
+// matching one of them (and the containers leading to them) are.  Values
+// matching an exclude pattern are always dropped.  Dropped containers are
+// skipped over without being tokenized.
+class JsonFilter {
+public:
+	JsonFilter& include(const std::string& pattern) {
+		includes.emplace_back(pattern);
+		return *this;
+	}
+
+	JsonFilter& exclude(const std::string& pattern) {
+		excludes.emplace_back(pattern);
+		return *this;
+	}
+
+	// Filters every top level value in the stream.  Returns the number of
+	// top level values written.
+	template <class source, class dest>
+	size_t copy(JsonParser<source>& parser, JsonGenerator<dest>& generator, size_t maxDepth = 50) {
+		size_t count = 0;
+		while (parser.nextToken() != JsonToken::NOT_AVAILABLE) {
+			if (copyValue(parser, generator, maxDepth)) {
+				++count;
+			}
+		}
+		return count;
+	}
+
+	// Filters the value at the parser's current token, leaving the parser on
+	// its last token.  Returns false if nothing was written.
+	template <class source, class dest>
+	bool copyValue(JsonParser<source>& parser, JsonGenerator<dest>& generator, size_t maxDepth = 50) {
+		path.clear();
+		Decision root = decide(includes.empty() ? KEEP_ALL : PARTIAL);
+		if (!keep(root, parser.currentToken())) {
+			parser.fastSkipChildren();
+			return false;
+		}
+		copyFiltered(parser, generator, root, maxDepth);
+		return true;
+	}
+
+private:
+	enum Decision {
+		DROP,
+		PARTIAL,
+		KEEP_ALL
+	};
+
+	std::vector<JsonPath> includes;
+	std::vector<JsonPath> excludes;
+	std::vector<JsonPathElement> path;
+
+	Decision decide(Decision parent) const {
+		for (const auto& pattern : excludes) {
+			if (pattern.matches(path)) {
+				return DROP;
+			}
+		}
+		if (parent == KEEP_ALL) {
+			return KEEP_ALL;
+		}
+		bool partial = false;
+		for (const auto& pattern : includes) {
+			int match = pattern.match(path);
+			if (match & JsonPath::FULL_MATCH) {
+				return KEEP_ALL;
+			}
+			partial |= (match & JsonPath::PREFIX_MATCH) != 0;
+		}
+		return partial ? PARTIAL : DROP;
+	}
+
+	// Scalars can only be kept if they match outright
+	static bool keep(Decision decision, JsonToken token) {
+		return decision == KEEP_ALL || (decision == PARTIAL && (token == JsonToken::START_OBJECT || token == JsonToken::START_ARRAY));
+	}
+
+	template <class source, class dest>
+	void copyFiltered(JsonParser<source>& parser, JsonGenerator<dest>& generator, Decision decision, size_t maxDepth) {
+		JsonToken token = parser.currentToken();
+		if (token != JsonToken::START_OBJECT && token != JsonToken::START_ARRAY) {
+			generator.copyCurrentEvent(parser);
+			return;
+		}
+		if (decision == KEEP_ALL && excludes.empty()) {
+			generator.copyCurrentStructure(parser);
+			return;
+		}
+		if (maxDepth == 0) {
+			throw JsonException("Max depth exceeded while filtering");
+		}
+		generator.copyCurrentEvent(parser);
+		const bool isObject = token == JsonToken::START_OBJECT;
+		path.emplace_back();
+		path.back().isIndex = !isObject;
+		size_t index = 0;
+		for (;;) {
+			token = parser.nextToken();
+			if (token == JsonToken::END_OBJECT || token == JsonToken::END_ARRAY) {
+				break;
+			}
+			Decision child;
+			if (isObject) {
+				path.back().name = parser.getCurrentName();
+				child = decide(decision);
+				if (child == DROP) {
+					// Dropped fields aren't tokenized at all
+					parser.skipNextValue();
+					continue;
+				}
+				token = parser.nextToken();
+			} else {
+				path.back().index = index++;
+				child = decide(decision);
+			}
+			if (!keep(child, token)) {
+				parser.fastSkipChildren();
+				continue;
+			}
+			if (isObject) {
+				generator.writeFieldName(path.back().name);
+			}
+			copyFiltered(parser, generator, child, maxDepth - 1);
+		}
+		path.pop_back();
+		generator.copyCurrentEvent(parser);
+	}
+};
+}
+
+#endif
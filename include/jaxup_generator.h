@@ -23,8 +23,10 @@
 #ifndef JAXUP_GENERATOR_H
 #define JAXUP_GENERATOR_H
 
+#include <cmath>
 #include <cstring>
 #include <iostream>
+#include <string>
 #include <vector>
 
 #include "jaxup_common.h"
@@ -32,6 +34,36 @@
 
 namespace jaxup {
 
+template <class source>
+class JsonParser;
+
+// Orders strings by their UTF-16 code units, which is how RFC 8785 sorts keys.
+// UTF-8 byte order agrees except between U+E000-U+FFFF and characters outside
+// the BMP, whose surrogates sort first in UTF-16.
+inline int compareUtf16(const char* a, std::size_t aLength, const char* b, std::size_t bLength) {
+	const std::size_t length = aLength < bLength ? aLength : bLength;
+	std::size_t i = 0;
+	while (i < length && a[i] == b[i]) {
+		++i;
+	}
+	if (i == length) {
+		return aLength < bLength ? -1 : (aLength > bLength ? 1 : 0);
+	}
+	const unsigned char ca = a[i];
+	const unsigned char cb = b[i];
+	if (ca >= 0xF0 && cb >= 0xEE && cb < 0xF0) {
+		return -1;
+	}
+	if (cb >= 0xF0 && ca >= 0xEE && ca < 0xF0) {
+		return 1;
+	}
+	return ca < cb ? -1 : 1;
+}
+
+inline int compareUtf16(const std::string& a, const std::string& b) {
+	return compareUtf16(a.data(), a.size(), b.data(), b.size());
+}
+
 template <class source, size_t size>
 class JsonDestination {
 };
@@ -39,14 +71,17 @@ class JsonDestination {
 template <size_t size>
 class JsonDestination<std::ostream, size> {
 public:
-	JsonDestination(std::ostream& output) : output(output) {
+	JsonDestination(std::ostream& output) : output(&output) {
+	}
+	inline void reset(std::ostream& newOutput) {
+		output = &newOutput;
 	}
 	inline void write(char bytes[size], size_t count) {
-		output.write(bytes, count);
+		output->write(bytes, count);
 	}
 
 private:
-	std::ostream& output;
+	std::ostream* output;
 };
 
 template <size_t size>
@@ -54,6 +89,9 @@ class JsonDestination<FILE*, size> {
 public:
 	JsonDestination(FILE* output) : output(output) {
 	}
+	inline void reset(FILE* newOutput) {
+		output = newOutput;
+	}
 	inline void write(char bytes[size], size_t count) {
 		fwrite(bytes, 1, count, output);
 	}
@@ -62,6 +100,22 @@ private:
 	FILE* output;
 };
 
+template <size_t size>
+class JsonDestination<std::string, size> {
+public:
+	JsonDestination(std::string& output) : output(&output) {
+	}
+	inline void reset(std::string& newOutput) {
+		output = &newOutput;
+	}
+	inline void write(char bytes[size], size_t count) {
+		output->append(bytes, count);
+	}
+
+private:
+	std::string* output;
+};
+
 template <class dest>
 class JsonGenerator {
 private:
@@ -74,7 +128,12 @@ private:
 	JsonToken token = JsonToken::NOT_AVAILABLE;
 	std::vector<JsonToken> tagStack;
 	std::string prettyBuff = "\n";
+	std::string rootValueSeparator;
 	bool prettyPrint;
+	bool rootValueWritten = false;
+	bool canonical = false;
+	// The last key written at each open object, in canonical mode
+	std::vector<std::string> canonicalKeys;
 
 	inline void writeBuff(char c) {
 		if (outputSize >= initialBuffSize) {
@@ -84,18 +143,16 @@ private:
 	}
 
 	inline void writeBuff(const char* c, std::size_t length) {
-		if (outputSize + length <= initialBuffSize) {
-			std::memcpy(&outputBuffer[outputSize], c, length);
-			outputSize += length;
-		} else {
+		while (outputSize + length > initialBuffSize) {
 			std::size_t first = initialBuffSize - outputSize;
 			std::memcpy(&outputBuffer[outputSize], c, first);
 			outputSize = initialBuffSize;
 			flush();
+			c += first;
 			length -= first;
-			std::memcpy(outputBuffer, c + first, length);
-			outputSize += length;
 		}
+		std::memcpy(&outputBuffer[outputSize], c, length);
+		outputSize += length;
 	}
 
 	inline void writePrettyBuff() {
@@ -114,6 +171,11 @@ private:
 			if (prettyPrint && parent == JsonToken::START_ARRAY) {
 				writePrettyBuff();
 			}
+		} else if (!rootValueSeparator.empty()) {
+			if (rootValueWritten) {
+				writeBuff(rootValueSeparator.c_str(), rootValueSeparator.length());
+			}
+			rootValueWritten = true;
 		}
 	}
 
@@ -163,7 +225,7 @@ private:
 				if (c < 10) {
 					unicodeBuff[5] = c + '0';
 				} else {
-					unicodeBuff[5] = c - 10 + 'A';
+					unicodeBuff[5] = c - 10 + (canonical ? 'a' : 'A');
 				}
 				writeBuff(unicodeBuff, 6);
 			}
@@ -175,7 +237,10 @@ private:
 	}
 
 	inline int writeDoubleToBuff(double value, char* buff) {
-		int len = numeric::ryu(value, buff);
+		if (canonical && !std::isfinite(value)) {
+			throw JsonException("Canonical JSON cannot represent NaN or infinity");
+		}
+		int len = numeric::ryu(value, buff, canonical);
 		if (len < 0) {
 			throw JsonException("Failed to serialize double");
 		}
@@ -190,10 +255,39 @@ public:
 		tagStack.reserve(32);
 	}
 
+	// Starts pretty printing as if already nested indentDepth levels deep, so that
+	// a fragment can be generated separately and spliced in with writeRawValue.
+	JsonGenerator(dest& output, bool prettyPrint, size_t indentDepth) : JsonGenerator(output, prettyPrint) {
+		if (prettyPrint) {
+			prettyBuff.append(indentDepth, '\t');
+		}
+	}
+
 	~JsonGenerator() {
 		flush();
 	}
 
+	// Flushes anything still pending to the previous destination, then rebinds
+	// the generator to a new one with a clean state.
+	void reset(dest& newOutput, bool newPrettyPrint) {
+		flush();
+		output.reset(newOutput);
+		token = JsonToken::NOT_AVAILABLE;
+		tagStack.clear();
+		canonical = false;
+		canonicalKeys.clear();
+		rootValueSeparator.clear();
+		prettyBuff = "\n";
+		prettyPrint = newPrettyPrint;
+		rootValueWritten = false;
+	}
+
+	// Text written between consecutive top level values, e.g. "\n" to produce
+	// newline delimited output.  Nothing by default.
+	void setRootValueSeparator(const std::string& separator) {
+		rootValueSeparator = separator;
+	}
+
 	void flush() {
 		if (outputSize > 0) {
 			output.write(outputBuffer, outputSize);
@@ -214,6 +308,11 @@ public:
 	}
 
 	void write(int64_t value) {
+		if (canonical && (value > (int64_t(1) << 53) || value < -(int64_t(1) << 53))) {
+			// Canonical numbers are doubles
+			write(static_cast<double>(value));
+			return;
+		}
 		prepareWriteValue();
 		token = JsonToken::VALUE_NUMBER_INT;
 		char* start = numeric::writeIntegerToBuff(value, doubleBuffEndMarker);
@@ -258,9 +357,60 @@ public:
 		encodeString(value.c_str(), value.length());
 	}
 
-	void writeFieldName(const std::string& field) {
+	void write(const char* value, std::size_t length) {
+		prepareWriteValue();
+		token = JsonToken::VALUE_STRING;
+		encodeString(value, length);
+	}
+
+	// Writes an already serialized value verbatim, taking care of any separators.
+	void writeRawValue(const char* json, std::size_t length) {
+		prepareWriteValue();
+		token = JsonToken::NOT_AVAILABLE; // Only need to know that a value was written
+		writeBuff(json, length);
+	}
+
+	inline void writeRawValue(const std::string& json) {
+		writeRawValue(json.data(), json.length());
+	}
+
+	std::size_t getDepth() const {
+		return tagStack.size();
+	}
+
+	bool isPrettyPrint() const {
+		return prettyPrint;
+	}
+
+	// Writes RFC 8785 canonical JSON: no whitespace, ECMAScript number
+	// formatting, and lower case escapes.  Keys must be written in sorted
+	// order (JsonNode::write takes care of that), which is checked.  Set this
+	// before writing anything.
+	void setCanonical(bool newCanonical) {
+		canonical = newCanonical;
+		if (canonical) {
+			prettyPrint = false;
+		}
+	}
+
+	bool isCanonical() const {
+		return canonical;
+	}
+
+	inline void writeFieldName(const std::string& field) {
+		writeFieldName(field.c_str(), field.length());
+	}
+
+	void writeFieldName(const char* field, std::size_t length) {
 		if (tagStack.empty() || tagStack.back() != JsonToken::START_OBJECT) {
-			throw JsonException("Tried to write a field name outside of an object: ", field);
+			throw JsonException("Tried to write a field name outside of an object: ", std::string(field, length));
+		}
+		if (canonical) {
+			std::string& last = canonicalKeys.back();
+			if (token != JsonToken::START_OBJECT && compareUtf16(field, length, last.data(), last.size()) <= 0) {
+				throw JsonException("Keys must be unique and in sorted order in canonical JSON: ", std::string(field, length));
+			}
+			last.assign(field, length);
 		}
 		if (token != JsonToken::START_OBJECT) {
 			writeBuff(',');
@@ -269,7 +419,7 @@ public:
 			writePrettyBuff();
 		}
 		token = JsonToken::FIELD_NAME;
-		encodeString(field.c_str(), field.length());
+		encodeString(field, length);
 		if (!prettyPrint) {
 			writeBuff(':');
 		} else {
@@ -281,6 +431,9 @@ public:
 		prepareWriteValue();
 		token = JsonToken::START_OBJECT;
 		tagStack.push_back(token);
+		if (canonical) {
+			canonicalKeys.emplace_back();
+		}
 		writeBuff('{');
 		if (prettyPrint) {
 			prettyBuff.push_back('\t');
@@ -298,6 +451,9 @@ public:
 		}
 		token = JsonToken::END_OBJECT;
 		tagStack.pop_back();
+		if (canonical) {
+			canonicalKeys.pop_back();
+		}
 		if (prettyPrint) {
 			prettyBuff.pop_back();
 			writePrettyBuff();
@@ -338,6 +494,80 @@ public:
 		writeFieldName(field);
 		write(value);
 	}
+
+	// Writes out the parser's current token
+	template <class source>
+	void copyCurrentEvent(const JsonParser<source>& parser) {
+		switch (parser.currentToken()) {
+		case JsonToken::END_ARRAY:
+			endArray();
+			break;
+		case JsonToken::END_OBJECT:
+			endObject();
+			break;
+		case JsonToken::FIELD_NAME:
+			writeFieldName(parser.getCurrentName());
+			break;
+		case JsonToken::START_ARRAY:
+			startArray();
+			break;
+		case JsonToken::START_OBJECT:
+			startObject();
+			break;
+		case JsonToken::VALUE_FALSE:
+			write(false);
+			break;
+		case JsonToken::VALUE_NULL:
+			write(nullptr);
+			break;
+		case JsonToken::VALUE_NUMBER_FLOAT:
+			write(parser.getDoubleValue());
+			break;
+		case JsonToken::VALUE_NUMBER_INT:
+			write(parser.getIntegerValue());
+			break;
+		case JsonToken::VALUE_STRING:
+			write(parser.getText());
+			break;
+		case JsonToken::VALUE_TRUE:
+			write(true);
+			break;
+		case JsonToken::NOT_AVAILABLE:
+			break;
+		}
+	}
+
+	// Writes out the parser's current token along with all of its children (and
+	// its value, for a field name).  Leaves the parser on the last token copied.
+	// Returns the number of tokens copied.
+	template <class source>
+	size_t copyCurrentStructure(JsonParser<source>& parser) {
+		size_t count = 1;
+		if (parser.currentToken() == JsonToken::FIELD_NAME) {
+			writeFieldName(parser.getCurrentName());
+			parser.nextToken();
+			++count;
+		}
+		copyCurrentEvent(parser);
+		JsonToken t = parser.currentToken();
+		if (t != JsonToken::START_OBJECT && t != JsonToken::START_ARRAY) {
+			return count;
+		}
+		size_t depth = 1;
+		while (depth > 0) {
+			t = parser.nextToken();
+			if (t == JsonToken::START_OBJECT || t == JsonToken::START_ARRAY) {
+				++depth;
+			} else if (t == JsonToken::END_OBJECT || t == JsonToken::END_ARRAY) {
+				--depth;
+			} else if (t == JsonToken::NOT_AVAILABLE) {
+				throw JsonException("Unexpected end of stream while copying");
+			}
+			copyCurrentEvent(parser);
+			++count;
+		}
+		return count;
+	}
 };
 }
 
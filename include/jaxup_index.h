@@ -0,0 +1,190 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#ifndef JAXUP_INDEX_H
+#define JAXUP_INDEX_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "jaxup_common.h"
+#include "jaxup_node.h"
+#include "jaxup_parser.h"
+
+namespace jaxup {
+
+enum class JsonIndexLayout {
+	// Elements of a single top level array
+	ARRAY,
+	// A sequence of top level values, such as newline delimited JSON
+	SEQUENCE
+};
+
+struct JsonIndexEntry {
+	uint64_t offset;
+	uint64_t length;
+	// How deeply nested the element is; zero for scalars
+	uint32_t depth;
+};
+
+// Byte offsets of the elements of a large document, allowing any one of them to
+// be parsed without touching the rest.  Containers are skipped without being
+// tokenized while building, so building costs little more than reading the file.
+class JsonIndex {
+public:
+	JsonIndexLayout getLayout() const {
+		return layout;
+	}
+
+	size_t size() const {
+		return entries.size();
+	}
+
+	const JsonIndexEntry& operator[](size_t n) const {
+		return entries[n];
+	}
+
+	template <class source>
+	void build(JsonParser<source>& parser, JsonIndexLayout newLayout) {
+		layout = newLayout;
+		entries.clear();
+		JsonToken token = parser.nextToken();
+		if (layout == JsonIndexLayout::ARRAY) {
+			if (token != JsonToken::START_ARRAY) {
+				throw JsonException("Expected the document to be an array, but found: ", getTokenAsString(token));
+			}
+			token = parser.nextToken();
+			while (token != JsonToken::END_ARRAY) {
+				addEntry(parser, token);
+				token = parser.nextToken();
+			}
+		} else {
+			while (token != JsonToken::NOT_AVAILABLE) {
+				addEntry(parser, token);
+				token = parser.nextToken();
+			}
+		}
+	}
+
+	// Positions the parser just ahead of element n.  The following call to
+	// nextToken returns the first token of the element.
+	template <class source>
+	void seek(JsonParser<source>& parser, size_t n) const {
+		if (n >= entries.size()) {
+			throw JsonException("Index element out of range");
+		}
+		parser.seek(entries[n].offset, layout == JsonIndexLayout::ARRAY);
+	}
+
+	template <class source>
+	void read(JsonParser<source>& parser, size_t n, JsonNode& node) const {
+		seek(parser, n);
+		parser.nextToken();
+		size_t maxDepth = entries[n].depth + 1;
+		node.read(parser, maxDepth > 50 ? maxDepth : 50);
+	}
+
+	void save(FILE* output) const {
+		unsigned char header[24];
+		std::memcpy(header, magic, 8);
+		encode(header + 8, version, 4);
+		encode(header + 12, static_cast<uint64_t>(layout), 4);
+		encode(header + 16, entries.size(), 8);
+		bool ok = fwrite(header, 1, sizeof(header), output) == sizeof(header);
+		unsigned char entry[entrySize];
+		for (size_t i = 0; ok && i < entries.size(); ++i) {
+			encode(entry, entries[i].offset, 8);
+			encode(entry + 8, entries[i].length, 8);
+			encode(entry + 16, entries[i].depth, 4);
+			encode(entry + 20, 0, 4);
+			ok = fwrite(entry, 1, entrySize, output) == entrySize;
+		}
+		if (!ok) {
+			throw JsonException("Failed to write index");
+		}
+	}
+
+	void load(FILE* input) {
+		unsigned char header[24];
+		if (fread(header, 1, sizeof(header), input) != sizeof(header) || std::memcmp(header, magic, 8) != 0) {
+			throw JsonException("Not a jaxup index");
+		}
+		if (decode(header + 8, 4) != version) {
+			throw JsonException("Unsupported index version");
+		}
+		layout = decode(header + 12, 4) == 0 ? JsonIndexLayout::ARRAY : JsonIndexLayout::SEQUENCE;
+		uint64_t count = decode(header + 16, 8);
+		entries.clear();
+		unsigned char entry[entrySize];
+		for (uint64_t i = 0; i < count; ++i) {
+			if (fread(entry, 1, entrySize, input) != entrySize) {
+				throw JsonException("Index is truncated");
+			}
+			JsonIndexEntry e;
+			e.offset = decode(entry, 8);
+			e.length = decode(entry + 8, 8);
+			e.depth = static_cast<uint32_t>(decode(entry + 16, 4));
+			entries.push_back(e);
+		}
+	}
+
+private:
+	static constexpr const char* magic = "JAXUPIDX";
+	static const uint64_t version = 1;
+	static const size_t entrySize = 24;
+
+	JsonIndexLayout layout = JsonIndexLayout::ARRAY;
+	std::vector<JsonIndexEntry> entries;
+
+	template <class source>
+	void addEntry(JsonParser<source>& parser, JsonToken token) {
+		JsonIndexEntry entry;
+		entry.offset = parser.getTokenByteOffset();
+		size_t depth = 0;
+		if (token == JsonToken::START_OBJECT || token == JsonToken::START_ARRAY) {
+			parser.fastSkipChildren(&depth);
+		}
+		entry.length = parser.getCurrentByteOffset() - entry.offset;
+		entry.depth = static_cast<uint32_t>(depth);
+		entries.push_back(entry);
+	}
+
+	static void encode(unsigned char* out, uint64_t value, size_t bytes) {
+		for (size_t i = 0; i < bytes; ++i) {
+			out[i] = static_cast<unsigned char>(value >> (8 * i));
+		}
+	}
+
+	static uint64_t decode(const unsigned char* in, size_t bytes) {
+		uint64_t value = 0;
+		for (size_t i = 0; i < bytes; ++i) {
+			value |= static_cast<uint64_t>(in[i]) << (8 * i);
+		}
+		return value;
+	}
+};
+}
+
+#endif
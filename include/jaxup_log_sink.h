@@ -0,0 +1,305 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#ifndef JAXUP_LOG_SINK_H
+#define JAXUP_LOG_SINK_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <climits>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "jaxup_common.h"
+#include "jaxup_generator.h"
+
+namespace jaxup {
+
+struct JsonLogBuffer {
+	std::string data;
+	JsonLogBuffer* next = nullptr;
+};
+
+// Collects newline delimited JSON records from any number of threads and writes
+// them out on a dedicated thread.  Each thread formats into its own generator
+// and buffer, finished records are pushed onto a lock-free list, and the writer
+// hands everything it finds there to the OS in a single writev call.
+class JsonLogSink {
+public:
+	class Record {
+	public:
+		Record(Record&& rhs) noexcept : sink(rhs.sink), buffer(rhs.buffer) {
+			rhs.sink = nullptr;
+			rhs.buffer = nullptr;
+		}
+		Record(const Record&) = delete;
+		Record& operator=(const Record&) = delete;
+
+		// Publishes the record if it is complete, otherwise silently drops it.
+		~Record() {
+			if (buffer != nullptr) {
+				ThreadState& state = getThreadState();
+				state.generator.flush();
+				if (state.generator.getDepth() == 0 && !buffer->data.empty()) {
+					sink->publish(buffer);
+				} else {
+					state.release(buffer);
+				}
+				state.inUse = false;
+			}
+		}
+
+		JsonGenerator<std::string>& operator*() const {
+			return getThreadState().generator;
+		}
+
+		JsonGenerator<std::string>* operator->() const {
+			return &getThreadState().generator;
+		}
+
+	private:
+		friend class JsonLogSink;
+		Record(JsonLogSink* sink, JsonLogBuffer* buffer) : sink(sink), buffer(buffer) {
+		}
+
+		JsonLogSink* sink;
+		JsonLogBuffer* buffer;
+	};
+
+	explicit JsonLogSink(FILE* output) : output(output) {
+		fflush(output);
+		writer = std::thread(&JsonLogSink::run, this);
+	}
+
+	JsonLogSink(const JsonLogSink&) = delete;
+	JsonLogSink& operator=(const JsonLogSink&) = delete;
+
+	~JsonLogSink() {
+		stopping.store(true, std::memory_order_release);
+		writer.join();
+		deleteList(freeBuffers.exchange(nullptr));
+	}
+
+	// Starts a new record on the calling thread.  Only one record per thread
+	// may be open at a time.
+	Record startRecord() {
+		ThreadState& state = getThreadState();
+		if (state.inUse) {
+			throw JsonException("Only one log record may be open per thread");
+		}
+		JsonLogBuffer* buffer = state.acquire(freeBuffers);
+		state.generator.reset(buffer->data, false);
+		state.inUse = true;
+		return Record(this, buffer);
+	}
+
+	// Blocks until every record published so far has been handed to the OS.
+	void flush() {
+		const uint64_t target = published.load(std::memory_order_acquire);
+		while (written.load(std::memory_order_acquire) < target) {
+			std::this_thread::sleep_for(std::chrono::microseconds(50));
+		}
+	}
+
+	bool hasFailed() const {
+		return failed.load(std::memory_order_relaxed);
+	}
+
+private:
+	static const size_t maxCachedBuffers = 64;
+	static const size_t maxRetainedCapacity = 64 * 1024;
+
+	struct ThreadState {
+		std::string scratch;
+		JsonGenerator<std::string> generator;
+		JsonLogBuffer* cache = nullptr;
+		size_t numCached = 0;
+		bool inUse = false;
+
+		ThreadState() : generator(scratch, false) {
+		}
+
+		~ThreadState() {
+			deleteList(cache);
+		}
+
+		JsonLogBuffer* acquire(std::atomic<JsonLogBuffer*>& shared) {
+			if (cache == nullptr) {
+				cache = shared.exchange(nullptr, std::memory_order_acquire);
+				numCached = 0;
+				for (JsonLogBuffer* b = cache; b != nullptr; b = b->next) {
+					++numCached;
+				}
+			}
+			if (cache == nullptr) {
+				return new JsonLogBuffer;
+			}
+			JsonLogBuffer* buffer = cache;
+			cache = buffer->next;
+			--numCached;
+			buffer->data.clear();
+			return buffer;
+		}
+
+		void release(JsonLogBuffer* buffer) {
+			if (numCached >= maxCachedBuffers) {
+				delete buffer;
+				return;
+			}
+			buffer->next = cache;
+			cache = buffer;
+			++numCached;
+		}
+	};
+
+	FILE* output;
+	std::thread writer;
+	std::atomic<JsonLogBuffer*> pending{nullptr};
+	std::atomic<JsonLogBuffer*> freeBuffers{nullptr};
+	std::atomic<uint64_t> published{0};
+	std::atomic<uint64_t> written{0};
+	std::atomic<bool> stopping{false};
+	std::atomic<bool> failed{false};
+
+	static ThreadState& getThreadState() {
+		static thread_local ThreadState state;
+		return state;
+	}
+
+	static void deleteList(JsonLogBuffer* list) {
+		while (list != nullptr) {
+			JsonLogBuffer* next = list->next;
+			delete list;
+			list = next;
+		}
+	}
+
+	static void push(std::atomic<JsonLogBuffer*>& list, JsonLogBuffer* first, JsonLogBuffer* last) {
+		last->next = list.load(std::memory_order_relaxed);
+		while (!list.compare_exchange_weak(last->next, first, std::memory_order_release, std::memory_order_relaxed))
+			;
+	}
+
+	void publish(JsonLogBuffer* buffer) {
+		buffer->data.push_back('\n');
+		published.fetch_add(1, std::memory_order_relaxed);
+		push(pending, buffer, buffer);
+	}
+
+	void writeAll(std::vector<JsonLogBuffer*>& batch) {
+#ifdef _WIN32
+		for (JsonLogBuffer* buffer : batch) {
+			if (fwrite(buffer->data.data(), 1, buffer->data.size(), output) != buffer->data.size()) {
+				failed.store(true, std::memory_order_relaxed);
+			}
+		}
+		fflush(output);
+#else
+		const int fd = fileno(output);
+		std::vector<struct iovec> iov;
+		iov.reserve(batch.size() < IOV_MAX ? batch.size() : IOV_MAX);
+		size_t next = 0;
+		while (next < batch.size()) {
+			iov.clear();
+			for (; next < batch.size() && iov.size() < IOV_MAX; ++next) {
+				struct iovec v;
+				v.iov_base = &batch[next]->data[0];
+				v.iov_len = batch[next]->data.size();
+				iov.push_back(v);
+			}
+			size_t first = 0;
+			while (first < iov.size()) {
+				ssize_t count = writev(fd, &iov[first], static_cast<int>(iov.size() - first));
+				if (count < 0) {
+					if (errno == EINTR) {
+						continue;
+					}
+					failed.store(true, std::memory_order_relaxed);
+					break;
+				}
+				// Skip over whatever made it out on a partial write
+				size_t remaining = static_cast<size_t>(count);
+				while (first < iov.size() && remaining >= iov[first].iov_len) {
+					remaining -= iov[first].iov_len;
+					++first;
+				}
+				if (remaining > 0) {
+					iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + remaining;
+					iov[first].iov_len -= remaining;
+				}
+			}
+		}
+#endif
+	}
+
+	void run() {
+		std::vector<JsonLogBuffer*> batch;
+		unsigned int idleRounds = 0;
+		for (;;) {
+			// Checked before draining so that nothing published ahead of shutdown is lost
+			const bool stop = stopping.load(std::memory_order_acquire);
+			JsonLogBuffer* list = pending.exchange(nullptr, std::memory_order_acquire);
+			if (list == nullptr) {
+				if (stop) {
+					return;
+				}
+				if (++idleRounds < 64) {
+					std::this_thread::yield();
+				} else {
+					std::this_thread::sleep_for(std::chrono::microseconds(idleRounds < 1024 ? 50 : 1000));
+				}
+				continue;
+			}
+			idleRounds = 0;
+			batch.clear();
+			for (; list != nullptr; list = list->next) {
+				batch.push_back(list);
+			}
+			// The list comes off the stack newest first
+			std::reverse(batch.begin(), batch.end());
+			writeAll(batch);
+
+			for (size_t i = 0; i < batch.size(); ++i) {
+				if (batch[i]->data.capacity() > maxRetainedCapacity) {
+					std::string().swap(batch[i]->data);
+				}
+				batch[i]->next = i + 1 < batch.size() ? batch[i + 1] : nullptr;
+			}
+			push(freeBuffers, batch.front(), batch.back());
+			written.fetch_add(batch.size(), std::memory_order_release);
+		}
+	}
+};
+}
+
+#endif
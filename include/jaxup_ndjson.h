@@ -0,0 +1,211 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+
+#ifndef JAXUP_NDJSON_H
+#define JAXUP_NDJSON_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "jaxup_common.h"
+#include "jaxup_parser.h"
+#include "jaxup_pool.h"
+#include "jaxup_thread_pool.h"
+
+namespace jaxup {
+
+// Processes newline delimited JSON on a thread pool.  The input is cut into
+// blocks at line boundaries, every block is parsed by a worker with its own
+// parser and output buffer, and the outputs are handed back in input order.
+class JsonNdjsonProcessor {
+public:
+	// Called once per block with a parser over the block and a buffer to
+	// append output to.  May be called from several threads at once.
+	using BlockFunction = std::function<void(JsonParser<std::string>& parser, std::string& output)>;
+	// Like BlockFunction, but given the block's raw bytes
+	using RawBlockFunction = std::function<void(std::string& input, std::string& output)>;
+	// Called on the calling thread with each block's output, in order.
+	using OutputFunction = std::function<void(const std::string& output)>;
+
+	explicit JsonNdjsonProcessor(JsonThreadPool& pool) : pool(pool) {
+	}
+
+	// Approximate number of input bytes per block.  Lines are never split, so
+	// a block grows to hold a line longer than this.
+	JsonNdjsonProcessor& setBlockSize(size_t newBlockSize) {
+		blockSize = std::max<size_t>(newBlockSize, 1);
+		return *this;
+	}
+
+	// Limits how many blocks may be buffered ahead of the one being output.
+	JsonNdjsonProcessor& setMaxBlocksInFlight(size_t newMaxBlocksInFlight) {
+		maxBlocksInFlight = newMaxBlocksInFlight;
+		return *this;
+	}
+
+	// Returns the number of input bytes processed.  Exceptions thrown by
+	// either function are rethrown once outstanding blocks have finished.
+	uint64_t process(FILE* input, const BlockFunction& processBlock, const OutputFunction& consume) {
+		return processBlocks(input, [&processBlock](std::string& block, std::string& output) {
+			auto parser = acquireJsonParser(block);
+			processBlock(*parser, output);
+		}, consume);
+	}
+
+	// Writes each block's output to a file
+	uint64_t process(FILE* input, FILE* output, const BlockFunction& processBlock) {
+		return process(input, processBlock, [output](const std::string& data) {
+			if (fwrite(data.data(), 1, data.size(), output) != data.size()) {
+				throw JsonException("Failed to write output");
+			}
+		});
+	}
+
+	uint64_t processBlocks(FILE* input, const RawBlockFunction& processBlock, const OutputFunction& consume) {
+		size_t inFlight = maxBlocksInFlight;
+		if (inFlight == 0) {
+			inFlight = pool.size() * 4;
+		}
+		std::vector<std::unique_ptr<Block>> window;
+		std::string carry;
+		uint64_t totalBytes = 0;
+		bool endOfInput = false;
+		size_t next = 0;
+		std::exception_ptr error;
+		while (!error && (!endOfInput || next < window.size())) {
+			while (!endOfInput && window.size() - next < inFlight) {
+				std::unique_ptr<Block> block(new Block);
+				try {
+					endOfInput = readBlock(input, carry, block->input);
+				} catch (...) {
+					error = std::current_exception();
+					endOfInput = true;
+					break;
+				}
+				totalBytes += block->input.size();
+				if (block->input.empty()) {
+					break;
+				}
+				Block* rawBlock = block.get();
+				window.push_back(std::move(block));
+				pool.submit([this, rawBlock, &processBlock]() {
+					runBlock(*rawBlock, processBlock);
+				});
+			}
+			if (error || next == window.size()) {
+				break;
+			}
+			Block& block = *window[next];
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				blockDone.wait(lock, [&block]() { return block.done; });
+			}
+			if (block.error) {
+				error = block.error;
+			} else {
+				try {
+					consume(block.output);
+				} catch (...) {
+					error = std::current_exception();
+				}
+			}
+			window[next++].reset();
+		}
+		for (; next < window.size(); ++next) {
+			Block& block = *window[next];
+			std::unique_lock<std::mutex> lock(mutex);
+			blockDone.wait(lock, [&block]() { return block.done; });
+		}
+		if (error) {
+			std::rethrow_exception(error);
+		}
+		return totalBytes;
+	}
+
+private:
+	struct Block {
+		std::string input;
+		std::string output;
+		std::exception_ptr error;
+		bool done = false;
+	};
+
+	JsonThreadPool& pool;
+	size_t blockSize = 1 << 20;
+	size_t maxBlocksInFlight = 0;
+	std::mutex mutex;
+	std::condition_variable blockDone;
+
+	// Fills data with whole lines, keeping any partial line for next time.
+	// Returns true at the end of the input.
+	bool readBlock(FILE* input, std::string& carry, std::string& data) {
+		data.swap(carry);
+		carry.clear();
+		for (;;) {
+			size_t oldSize = data.size();
+			size_t wanted = oldSize < blockSize ? blockSize - oldSize : blockSize;
+			data.resize(oldSize + wanted);
+			size_t count = fread(&data[oldSize], 1, wanted, input);
+			data.resize(oldSize + count);
+			if (count == 0) {
+				if (ferror(input)) {
+					throw JsonException("Failed to read input");
+				}
+				return true;
+			}
+			// The carried over part never holds a newline
+			for (size_t i = data.size(); i > oldSize; --i) {
+				if (data[i - 1] == '\n') {
+					carry.assign(data, i, std::string::npos);
+					data.resize(i);
+					return false;
+				}
+			}
+		}
+	}
+
+	void runBlock(Block& block, const RawBlockFunction& processBlock) {
+		try {
+			processBlock(block.input, block.output);
+		} catch (...) {
+			block.error = std::current_exception();
+		}
+		// Notified under the lock, since the reader may return and destroy
+		// the condition variable as soon as it sees the last block done
+		std::lock_guard<std::mutex> lock(mutex);
+		block.done = true;
+		blockDone.notify_all();
+	}
+};
+}
+
+#endif
@@ -26,10 +26,20 @@
 #include "jaxup_common.h"
 #include "jaxup_generator.h"
 #include "jaxup_parser.h"
+#include "jaxup_path.h"
+#include "jaxup_recycler.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <functional>
 #include <memory>
 #include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace jaxup {
@@ -65,40 +75,106 @@ static inline std::string getNodeTypeAsString(JsonNodeType t) {
 	}
 }
 
+// Deduplicates string values shared by nodes.  Pooled strings are never
+// freed individually, so the pool must outlive every node that uses it.
+class JsonStringPool {
+public:
+	// Longer strings rarely repeat, so they are left to their nodes
+	void setMaxLength(size_t length) {
+		maxLength = length;
+	}
+
+	size_t getMaxLength() const {
+		return maxLength;
+	}
+
+	const std::string& intern(const std::string& value) {
+		return *strings.insert(value).first;
+	}
+
+	size_t size() const {
+		return strings.size();
+	}
+
+private:
+	struct Hash {
+		size_t operator()(const std::string& value) const {
+			uint64_t hash = 14695981039346656037ULL;
+			for (char c : value) {
+				hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+			}
+			return static_cast<size_t>(hash);
+		}
+	};
+	// Nodes keep pointers into the set, which stay valid across rehashing
+	std::unordered_set<std::string, Hash> strings;
+	size_t maxLength = 64;
+};
+
+// Expected numbers of children for the containers at given paths, so that
+// JsonNode::read can reserve room for them rather than growing as it goes.
+// A JsonIndex's size, for instance, is the count for an indexed array.
+class JsonSizeHints {
+public:
+	void add(const std::string& pattern, size_t count) {
+		hints.emplace_back(JsonPath(pattern), count);
+	}
+
+	bool empty() const {
+		return hints.empty();
+	}
+
+	// Combines the JsonPath::match results of every hint, setting count from
+	// the first that matches in full
+	int match(const std::vector<JsonPathElement>& path, size_t& count) const {
+		int result = 0;
+		for (const auto& hint : hints) {
+			int match = hint.first.match(path);
+			if ((match & JsonPath::FULL_MATCH) != 0 && (result & JsonPath::FULL_MATCH) == 0) {
+				count = hint.second;
+			}
+			result |= match;
+		}
+		return result;
+	}
+
+private:
+	std::vector<std::pair<JsonPath, size_t>> hints;
+};
+
 class JsonNode {
 public:
 	JsonNode() = default;
-	JsonNode(JsonNode&& rhs) {
-		type = rhs.type;
-		switch (type) {
-		case JsonNodeType::VALUE_OBJECT:
-			value.object = std::move(rhs.value.object);
-			break;
-		case JsonNodeType::VALUE_ARRAY:
-			value.array = std::move(rhs.value.array);
-			break;
-		case JsonNodeType::VALUE_STRING:
-			value.str = std::move(rhs.value.str);
-			break;
-		case JsonNodeType::VALUE_NUMBER_INT:
-			value.i = rhs.value.i;
-			break;
-		case JsonNodeType::VALUE_NUMBER_FLOAT:
-			value.d = rhs.value.d;
-			break;
-		case JsonNodeType::VALUE_BOOLEAN:
-			value.b = rhs.value.b;
-			break;
-		default:
-			value.i = 0;
-		}
-		rhs.type = JsonNodeType::VALUE_NULL;
-		rhs.value.i = 0;
+	// Moves are noexcept so that containers of nodes move rather than copy
+	// them when they grow
+	JsonNode(JsonNode&& rhs) noexcept {
+		takeFrom(rhs);
+	}
+	JsonNode(const JsonNode& rhs) {
+		copyFrom(rhs);
+	}
+	// rhs may live inside this node, so it's taken before this is cleared
+	JsonNode& operator=(JsonNode&& rhs) noexcept {
+		JsonNode taken(std::move(rhs));
+		makeNull();
+		takeFrom(taken);
+		return *this;
+	}
+	JsonNode& operator=(const JsonNode& rhs) {
+		JsonNode copy(rhs);
+		swap(copy);
+		return *this;
 	}
 	~JsonNode() {
 		makeNull();
 	}
 
+	void swap(JsonNode& rhs) noexcept {
+		JsonNode taken(std::move(rhs));
+		rhs.takeFrom(*this);
+		takeFrom(taken);
+	}
+
 	void copyFrom(const JsonNode& rhs, size_t maxDepth = 50) {
 		switch (rhs.type) {
 		case JsonNodeType::VALUE_OBJECT:
@@ -113,6 +189,7 @@ public:
 				newNode.copyFrom(pair.second, maxDepth - 1);
 				value.object->emplace_back(pair.first, std::move(newNode));
 			}
+			sortedKeys = rhs.sortedKeys;
 			break;
 		case JsonNodeType::VALUE_ARRAY:
 			if (maxDepth == 0) {
@@ -128,7 +205,7 @@ public:
 			}
 			break;
 		case JsonNodeType::VALUE_STRING:
-			setString(*rhs.value.str);
+			setString(rhs.stringValue());
 			break;
 		case JsonNodeType::VALUE_NUMBER_INT:
 			setInteger(rhs.value.i);
@@ -305,7 +382,7 @@ public:
 
 	const std::string& asString() const {
 		if (this->type == JsonNodeType::VALUE_STRING) {
-			return *this->value.str;
+			return stringValue();
 		}
 		throw JsonException("Attempted to read JSON ", getNodeTypeAsString(this->type), " node as a String");
 	}
@@ -337,17 +414,28 @@ public:
 
 	void setString(const std::string& newValue) {
 		setType(JsonNodeType::VALUE_STRING);
-		new (&this->value.str) StrPtr(new std::string(newValue));
+		new (&this->value.str) StrPtr(newNodeString(newValue.data(), newValue.size()));
 	}
 
 	void setString(const char* newValue) {
 		setType(JsonNodeType::VALUE_STRING);
-		new (&this->value.str) StrPtr(new std::string(newValue));
+		new (&this->value.str) StrPtr(newNodeString(newValue, std::strlen(newValue)));
 	}
 
 	void setString(const char* newValue, size_t size) {
 		setType(JsonNodeType::VALUE_STRING);
-		new (&this->value.str) StrPtr(new std::string(newValue, size));
+		new (&this->value.str) StrPtr(newNodeString(newValue, size));
+	}
+
+	// Shares the pool's copy when the value is short enough to be pooled
+	void setString(const std::string& newValue, JsonStringPool& pool) {
+		if (newValue.size() > pool.getMaxLength()) {
+			setString(newValue);
+			return;
+		}
+		setType(JsonNodeType::VALUE_STRING);
+		this->value.pooledStr = &pool.intern(newValue);
+		this->pooled = true;
 	}
 
 	inline void operator = (const std::string& newValue) {
@@ -379,7 +467,7 @@ public:
 			return;
 		}
 		setType(JsonNodeType::VALUE_ARRAY);
-		new (&this->value.array) ArrayPtr(new std::vector<JsonNode>);
+		new (&this->value.array) ArrayPtr(new Array);
 	}
 
 	const JsonNode& operator[](size_t n) const {
@@ -396,7 +484,7 @@ public:
 		}
 		if (n >= this->value.array->size()) {
 			if (n == this->value.array->size()) {
-				this->value.array->emplace_back(JsonNode());
+				this->value.array->emplace_back();
 			} else {
 				this->value.array->resize(n + 1);
 			}
@@ -408,52 +496,120 @@ public:
 		if (this->type != JsonNodeType::VALUE_ARRAY) {
 			makeArray();
 		}
-		this->value.array->emplace_back(JsonNode());
+		this->value.array->emplace_back();
 		return this->value.array->back();
 	}
 
+	// Appends a child built from the value, which may be anything a node can
+	// be assigned from, including a node within this one
+	template <typename T>
+	JsonNode& emplace(T&& newValue) {
+		JsonNode child;
+		child = std::forward<T>(newValue);
+		return append() = std::move(child);
+	}
+
+	// Inserts a null node before index n, which may be the size of the array
+	JsonNode& insert(size_t n) {
+		if (this->type != JsonNodeType::VALUE_ARRAY) {
+			makeArray();
+		}
+		if (n > this->value.array->size()) {
+			throw JsonException("Attempted to insert into a JSON array past its end");
+		}
+		return *this->value.array->emplace(this->value.array->begin() + n);
+	}
+
+	void remove(size_t n) {
+		if (this->type != JsonNodeType::VALUE_ARRAY || n >= this->value.array->size()) {
+			throw JsonException("Attempted to remove a JSON array element, but the index is out of range");
+		}
+		this->value.array->erase(this->value.array->begin() + n);
+	}
+
 	void makeObject() {
 		if (this->type == JsonNodeType::VALUE_OBJECT) {
 			return;
 		}
 		setType(JsonNodeType::VALUE_OBJECT);
-		new (&this->value.object) ObjectPtr(new std::vector<std::pair<std::string, JsonNode>>);
+		new (&this->value.object) ObjectPtr(new Object);
+		this->sortedKeys = false;
 	}
 
 	const JsonNode& operator[](const std::string& key) const {
 		static const JsonNode nullNode;
+		const JsonNode* node = find(key);
+		return node != nullptr ? *node : nullNode;
+	}
+
+	// Sorted objects insert new keys in order, others append them
+	JsonNode& operator[](const std::string& key) {
 		if (this->type != JsonNodeType::VALUE_OBJECT) {
-			return nullNode;
+			makeObject();
 		}
-		for (auto& pair : *this->value.object) {
-			if (pair.first == key) {
-				return pair.second;
+		Object& fields = *this->value.object;
+		auto it = fields.end();
+		if (sortedKeys) {
+			it = lowerBound(fields, key);
+			if (it != fields.end() && it->first == key) {
+				return it->second;
+			}
+		} else {
+			for (auto& pair : fields) {
+				if (pair.first == key) {
+					return pair.second;
+				}
 			}
 		}
-		return nullNode;
+		return fields.emplace(it, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple())->second;
 	}
 
-	JsonNode& operator[](const std::string& key) {
+	// Returns null if there is no such field
+	const JsonNode* find(const std::string& key) const {
 		if (this->type != JsonNodeType::VALUE_OBJECT) {
-			makeObject();
+			return nullptr;
 		}
-		for (auto& pair : *this->value.object) {
-			if (pair.first == key) {
-				return pair.second;
-			}
+		size_t n = findField(key);
+		return n < this->value.object->size() ? &(*this->value.object)[n].second : nullptr;
+	}
+
+	inline JsonNode* find(const std::string& key) {
+		return const_cast<JsonNode*>(static_cast<const JsonNode*>(this)->find(key));
+	}
+
+	// Returns whether the field was present
+	bool remove(const std::string& key) {
+		if (this->type != JsonNodeType::VALUE_OBJECT) {
+			return false;
 		}
-		this->value.object->emplace_back(key, JsonNode());
-		return this->value.object->back().second;
+		size_t n = findField(key);
+		if (n == this->value.object->size()) {
+			return false;
+		}
+		// Erasing keeps the remaining fields in order
+		this->value.object->erase(this->value.object->begin() + n);
+		return true;
 	}
 
 	JsonNode& append(const std::string& key) {
 		if (this->type != JsonNodeType::VALUE_OBJECT) {
 			makeObject();
 		}
-		this->value.object->emplace_back(key, JsonNode());
+		if (this->sortedKeys && !this->value.object->empty() && key < this->value.object->back().first) {
+			this->sortedKeys = false;
+		}
+		this->value.object->emplace_back(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple());
 		return this->value.object->back().second;
 	}
 
+	// Sets the field as operator[] would find or add it
+	template <typename T>
+	JsonNode& emplace(const std::string& key, T&& newValue) {
+		JsonNode child;
+		child = std::forward<T>(newValue);
+		return (*this)[key] = std::move(child);
+	}
+
 	const std::pair<const std::string&, const JsonNode&> getField(size_t n) const {
 		if (this->type != JsonNodeType::VALUE_OBJECT) {
 			throw JsonException("Attempted to get a field out of a JSON ", getNodeTypeAsString(this->type), " node");
@@ -476,6 +632,20 @@ public:
 		return {val.first, val.second};
 	}
 
+	// Makes room for n children in an array or object
+	void reserve(size_t n) {
+		switch (this->type) {
+		case JsonNodeType::VALUE_ARRAY:
+			this->value.array->reserve(n);
+			break;
+		case JsonNodeType::VALUE_OBJECT:
+			this->value.object->reserve(n);
+			break;
+		default:
+			throw JsonException("Attempted to reserve space in a JSON ", getNodeTypeAsString(this->type), " node");
+		}
+	}
+
 	size_t size() const {
 		switch (this->type) {
 		case JsonNodeType::VALUE_ARRAY:
@@ -487,6 +657,63 @@ public:
 		}
 	}
 
+	// Orders object fields bytewise by key, keeping fields with the same key
+	// in their original order.  Sorted objects look fields up by binary
+	// search, and stay sorted until a field is appended out of order.
+	void sortKeys(bool recursive = true, size_t maxDepth = 50) {
+		if (this->type == JsonNodeType::VALUE_OBJECT) {
+			Object& fields = *this->value.object;
+			if (!sortedKeys) {
+				std::stable_sort(fields.begin(), fields.end(), [](const std::pair<std::string, JsonNode>& a, const std::pair<std::string, JsonNode>& b) {
+					return a.first < b.first;
+				});
+				sortedKeys = true;
+			}
+		}
+		if (!recursive || (this->type != JsonNodeType::VALUE_OBJECT && this->type != JsonNodeType::VALUE_ARRAY)) {
+			return;
+		}
+		if (maxDepth == 0) {
+			throw JsonException("Max depth exceeded while sorting keys");
+		}
+		if (this->type == JsonNodeType::VALUE_OBJECT) {
+			for (auto& pair : *this->value.object) {
+				pair.second.sortKeys(true, maxDepth - 1);
+			}
+		} else {
+			for (auto& child : *this->value.array) {
+				child.sortKeys(true, maxDepth - 1);
+			}
+		}
+	}
+
+	bool isSorted() const {
+		return this->type == JsonNodeType::VALUE_OBJECT && this->sortedKeys;
+	}
+
+	// Hashes the tree so that it agrees with deepEquals: numbers hash by
+	// value and objects regardless of key order.  Nothing is cached, so
+	// use a JsonHashCache to hash the same subtrees repeatedly.
+	uint64_t hash(size_t maxDepth = 50) const {
+		NoHashCache cache;
+		return hash(maxDepth, cache);
+	}
+
+	// Numbers compare by value and objects regardless of key order.  Use
+	// JsonHashCache::equal to rule out unequal subtrees by their hashes.
+	bool deepEquals(const JsonNode& rhs, size_t maxDepth = 50) const {
+		NoHashCache cache;
+		return deepEquals(rhs, maxDepth, cache);
+	}
+
+	inline bool operator == (const JsonNode& rhs) const {
+		return deepEquals(rhs);
+	}
+
+	inline bool operator != (const JsonNode& rhs) const {
+		return !deepEquals(rhs);
+	}
+
 	template <class dest>
 	void write(JsonGenerator<dest>& generator, size_t maxDepth = 50) const {
 		switch (type) {
@@ -503,7 +730,7 @@ public:
 			generator.write(value.b);
 			break;
 		case JsonNodeType::VALUE_STRING:
-			generator.write(*value.str);
+			generator.write(stringValue());
 			break;
 		case JsonNodeType::VALUE_ARRAY:
 			if (maxDepth == 0) {
@@ -520,9 +747,25 @@ public:
 				throw JsonException("Max depth exceeded while writing Object node");
 			}
 			generator.startObject();
-			for (const auto& pair : *value.object) {
-				generator.writeFieldName(pair.first);
-				pair.second.write(generator, maxDepth - 1);
+			if (generator.isCanonical()) {
+				// Sort references to the fields rather than the fields
+				std::vector<const std::pair<std::string, JsonNode>*> sorted;
+				sorted.reserve(value.object->size());
+				for (const auto& pair : *value.object) {
+					sorted.push_back(&pair);
+				}
+				std::sort(sorted.begin(), sorted.end(), [](const std::pair<std::string, JsonNode>* a, const std::pair<std::string, JsonNode>* b) {
+					return compareUtf16(a->first, b->first) < 0;
+				});
+				for (const auto* pair : sorted) {
+					generator.writeFieldName(pair->first);
+					pair->second.write(generator, maxDepth - 1);
+				}
+			} else {
+				for (const auto& pair : *value.object) {
+					generator.writeFieldName(pair.first);
+					pair.second.write(generator, maxDepth - 1);
+				}
 			}
 			generator.endObject();
 			break;
@@ -530,7 +773,37 @@ public:
 	}
 
 	template <class source>
-	void read(JsonParser<source>& parser, size_t maxDepth = 50) {
+	inline void read(JsonParser<source>& parser, size_t maxDepth = 50) {
+		read(parser, maxDepth, nullptr);
+	}
+
+	// Short string values are shared through the pool
+	template <class source>
+	inline void read(JsonParser<source>& parser, JsonStringPool& pool, size_t maxDepth = 50) {
+		read(parser, maxDepth, &pool);
+	}
+
+	// Containers matching a hint are reserved before they're filled
+	template <class source>
+	inline void read(JsonParser<source>& parser, const JsonSizeHints& hints, size_t maxDepth = 50) {
+		std::vector<JsonPathElement> path;
+		readHinted(parser, maxDepth, nullptr, hints, path);
+	}
+
+	template <class source>
+	inline void read(JsonParser<source>& parser, JsonStringPool& pool, const JsonSizeHints& hints, size_t maxDepth = 50) {
+		std::vector<JsonPathElement> path;
+		readHinted(parser, maxDepth, &pool, hints, path);
+	}
+
+private:
+	// Hash the same way as hash()
+	friend class CompactJsonDocument;
+	friend class JsonHashCache;
+	friend class JsonFieldHandle;
+
+	template <class source>
+	void read(JsonParser<source>& parser, size_t maxDepth, JsonStringPool* pool) {
 		JsonToken token = parser.currentToken();
 		if (token == JsonToken::NOT_AVAILABLE) {
 			// Give a kick start if the stream hasn't been read from
@@ -554,17 +827,22 @@ public:
 			setBoolean(false);
 			break;
 		case JsonToken::VALUE_STRING:
-			setString(parser.getText());
+			if (pool != nullptr) {
+				setString(parser.getText(), *pool);
+			} else {
+				setString(parser.getText());
+			}
 			break;
 		case JsonToken::START_ARRAY: {
 			if (maxDepth == 0) {
 				throw JsonException("Max depth exceeded while parsing Array node");
 			}
 			makeArray();
+			this->value.array->clear();
 			JsonNode newNode;
 			JsonToken current = parser.nextToken();
 			while (current != JsonToken::END_ARRAY && current != JsonToken::NOT_AVAILABLE) {
-				newNode.read(parser, maxDepth - 1);
+				newNode.read(parser, maxDepth - 1, pool);
 				this->value.array->emplace_back(std::move(newNode));
 				current = parser.currentToken();
 			}
@@ -574,13 +852,15 @@ public:
 				throw JsonException("Max depth exceeded while parsing Object node");
 			}
 			makeObject();
+			this->value.object->clear();
+			this->sortedKeys = false;
 			JsonNode newNode;
 			std::string fieldName;
 			JsonToken current = parser.nextToken();
 			while (current == JsonToken::FIELD_NAME) {
 				fieldName = parser.getCurrentName();
 				current = parser.nextToken();
-				newNode.read(parser, maxDepth - 1);
+				newNode.read(parser, maxDepth - 1, pool);
 				current = parser.currentToken();
 				this->value.object->emplace_back(fieldName, std::move(newNode));
 			}
@@ -591,11 +871,90 @@ public:
 		parser.nextToken();
 	}
 
-private:
+	// Tracks the path only as far down as some hint could still match, and
+	// reads anything below that as usual
+	template <class source>
+	void readHinted(JsonParser<source>& parser, size_t maxDepth, JsonStringPool* pool, const JsonSizeHints& hints, std::vector<JsonPathElement>& path) {
+		JsonToken token = parser.currentToken();
+		if (token == JsonToken::NOT_AVAILABLE) {
+			token = parser.nextToken();
+		}
+		if ((token != JsonToken::START_ARRAY && token != JsonToken::START_OBJECT) || maxDepth == 0) {
+			read(parser, maxDepth, pool);
+			return;
+		}
+		size_t count = 0;
+		int match = hints.match(path, count);
+		if (token == JsonToken::START_ARRAY) {
+			makeArray();
+			this->value.array->clear();
+		} else {
+			makeObject();
+			this->value.object->clear();
+			this->sortedKeys = false;
+		}
+		if ((match & JsonPath::FULL_MATCH) != 0) {
+			reserve(count);
+		}
+		if ((match & JsonPath::PREFIX_MATCH) == 0) {
+			read(parser, maxDepth, pool);
+			return;
+		}
+		path.emplace_back();
+		JsonNode newNode;
+		JsonToken current = parser.nextToken();
+		if (token == JsonToken::START_ARRAY) {
+			path.back().isIndex = true;
+			while (current != JsonToken::END_ARRAY && current != JsonToken::NOT_AVAILABLE) {
+				path.back().index = this->value.array->size();
+				newNode.readHinted(parser, maxDepth - 1, pool, hints, path);
+				this->value.array->emplace_back(std::move(newNode));
+				current = parser.currentToken();
+			}
+		} else {
+			while (current == JsonToken::FIELD_NAME) {
+				path.back().name = parser.getCurrentName();
+				current = parser.nextToken();
+				newNode.readHinted(parser, maxDepth - 1, pool, hints, path);
+				current = parser.currentToken();
+				this->value.object->emplace_back(path.back().name, std::move(newNode));
+			}
+		}
+		path.pop_back();
+		parser.nextToken();
+	}
+
 	JsonNodeType type = JsonNodeType::VALUE_NULL;
+	// Whether a string value is borrowed from a JsonStringPool
+	bool pooled = false;
+	// Whether an object's fields are in key order, so lookups can binary
+	// search.  Only meaningful while the node is an object.
+	bool sortedKeys = false;
 	using StrPtr = std::unique_ptr<std::string>;
-	using ArrayPtr = std::unique_ptr<std::vector<JsonNode>>;
-	using ObjectPtr = std::unique_ptr<std::vector<std::pair<std::string, JsonNode>>>;
+	// With JAXUP_USE_NODE_RECYCLER, containers and their buffers go through
+	// any active JsonNodeRecycler
+	struct Array : std::vector<JsonNode, JsonNodeAllocator<JsonNode>> {
+#ifdef JAXUP_USE_NODE_RECYCLER
+		static void* operator new(size_t size) {
+			return JsonNodeRecycler::allocate(size);
+		}
+		static void operator delete(void* p, size_t size) {
+			JsonNodeRecycler::deallocate(p, size);
+		}
+#endif
+	};
+	struct Object : std::vector<std::pair<std::string, JsonNode>, JsonNodeAllocator<std::pair<std::string, JsonNode>>> {
+#ifdef JAXUP_USE_NODE_RECYCLER
+		static void* operator new(size_t size) {
+			return JsonNodeRecycler::allocate(size);
+		}
+		static void operator delete(void* p, size_t size) {
+			JsonNodeRecycler::deallocate(p, size);
+		}
+#endif
+	};
+	using ArrayPtr = std::unique_ptr<Array>;
+	using ObjectPtr = std::unique_ptr<Object>;
 	union Value {
 		Value() { i = 0; }
 		~Value() {}
@@ -603,13 +962,254 @@ private:
 		double d;
 		bool b;
 		StrPtr str;
+		const std::string* pooledStr;
 		ArrayPtr array;
 		ObjectPtr object;
 	} value;
+	// Leaves rhs null.  This node's value must not hold a pointer.
+	void takeFrom(JsonNode& rhs) noexcept {
+		type = rhs.type;
+		sortedKeys = rhs.sortedKeys;
+		switch (type) {
+		case JsonNodeType::VALUE_OBJECT:
+			new (&value.object) ObjectPtr(std::move(rhs.value.object));
+			rhs.value.object.~ObjectPtr();
+			break;
+		case JsonNodeType::VALUE_ARRAY:
+			new (&value.array) ArrayPtr(std::move(rhs.value.array));
+			rhs.value.array.~ArrayPtr();
+			break;
+		case JsonNodeType::VALUE_STRING:
+			if (rhs.pooled) {
+				value.pooledStr = rhs.value.pooledStr;
+				pooled = true;
+				rhs.pooled = false;
+			} else {
+				new (&value.str) StrPtr(std::move(rhs.value.str));
+				rhs.value.str.~StrPtr();
+			}
+			break;
+		case JsonNodeType::VALUE_NUMBER_INT:
+			value.i = rhs.value.i;
+			break;
+		case JsonNodeType::VALUE_NUMBER_FLOAT:
+			value.d = rhs.value.d;
+			break;
+		case JsonNodeType::VALUE_BOOLEAN:
+			value.b = rhs.value.b;
+			break;
+		default:
+			value.i = 0;
+		}
+		rhs.type = JsonNodeType::VALUE_NULL;
+		rhs.value.i = 0;
+	}
+	static Object::const_iterator lowerBound(const Object& fields, const std::string& key) {
+		return std::lower_bound(fields.begin(), fields.end(), key, [](const std::pair<std::string, JsonNode>& field, const std::string& k) {
+			return field.first < k;
+		});
+	}
+	static Object::iterator lowerBound(Object& fields, const std::string& key) {
+		return fields.begin() + (lowerBound(static_cast<const Object&>(fields), key) - fields.cbegin());
+	}
+	// Index of the first field with the key, or the number of fields
+	size_t findField(const std::string& key) const {
+		const Object& fields = *this->value.object;
+		if (sortedKeys) {
+			auto it = lowerBound(fields, key);
+			return it != fields.end() && it->first == key ? it - fields.begin() : fields.size();
+		}
+		for (size_t i = 0; i < fields.size(); ++i) {
+			if (fields[i].first == key) {
+				return i;
+			}
+		}
+		return fields.size();
+	}
+	inline const std::string& stringValue() const {
+		return pooled ? *value.pooledStr : *value.str;
+	}
+	struct NoHashCache {
+		inline bool find(const JsonNode*, uint64_t&) const {
+			return false;
+		}
+		inline size_t visit(size_t) {
+			return 0;
+		}
+		inline void store(const JsonNode*, uint64_t, size_t) {
+		}
+	};
+	// Containers whose hashes are both in the cache and differ aren't equal
+	template <class Cache>
+	bool deepEquals(const JsonNode& rhs, size_t maxDepth, const Cache& cache) const {
+		if (this == &rhs) {
+			return true;
+		}
+		if (isNumeric() && rhs.isNumeric()) {
+			if (type == JsonNodeType::VALUE_NUMBER_INT && rhs.type == JsonNodeType::VALUE_NUMBER_INT) {
+				return value.i == rhs.value.i;
+			}
+			return asDouble() == rhs.asDouble();
+		}
+		if (type != rhs.type || size() != rhs.size()) {
+			return false;
+		}
+		uint64_t lhsHash;
+		uint64_t rhsHash;
+		if ((type == JsonNodeType::VALUE_ARRAY || type == JsonNodeType::VALUE_OBJECT)
+				&& cache.find(this, lhsHash) && cache.find(&rhs, rhsHash) && lhsHash != rhsHash) {
+			return false;
+		}
+		switch (type) {
+		case JsonNodeType::VALUE_NULL:
+			return true;
+		case JsonNodeType::VALUE_BOOLEAN:
+			return value.b == rhs.value.b;
+		case JsonNodeType::VALUE_STRING:
+			return stringValue() == rhs.stringValue();
+		case JsonNodeType::VALUE_ARRAY:
+			if (maxDepth == 0) {
+				throw JsonException("Max depth exceeded while comparing Array nodes");
+			}
+			for (size_t i = 0; i < value.array->size(); ++i) {
+				if (!(*value.array)[i].deepEquals((*rhs.value.array)[i], maxDepth - 1, cache)) {
+					return false;
+				}
+			}
+			return true;
+		case JsonNodeType::VALUE_OBJECT:
+			if (maxDepth == 0) {
+				throw JsonException("Max depth exceeded while comparing Object nodes");
+			}
+		{
+			const Object& fields = *value.object;
+			const Object& others = *rhs.value.object;
+			// Fields usually line up, so try the same position first
+			size_t i = 0;
+			while (i < fields.size() && fields[i].first == others[i].first && fields[i].second.deepEquals(others[i].second, maxDepth - 1, cache)) {
+				++i;
+			}
+			if (i == fields.size()) {
+				return true;
+			}
+			// Each field of rhs can only be matched once, so repeated keys
+			// have to be repeated on both sides
+			std::vector<bool> used(others.size(), false);
+			std::fill(used.begin(), used.begin() + static_cast<std::ptrdiff_t>(i), true);
+			for (; i < fields.size(); ++i) {
+				size_t match = others.size();
+				for (size_t k = rhs.findField(fields[i].first); k < others.size(); ++k) {
+					if (others[k].first != fields[i].first) {
+						if (rhs.sortedKeys) {
+							break;
+						}
+						continue;
+					}
+					if (!used[k] && fields[i].second.deepEquals(others[k].second, maxDepth - 1, cache)) {
+						match = k;
+						break;
+					}
+				}
+				if (match == others.size()) {
+					return false;
+				}
+				used[match] = true;
+			}
+			return true;
+		}
+		default:
+			return false;
+		}
+	}
+
+	// Containers look themselves up in the cache before hashing their
+	// children, and offer the result along with how many descendants it
+	// took, as counted by visit
+	template <class Cache>
+	uint64_t hash(size_t maxDepth, Cache& cache) const {
+		uint64_t hash = static_cast<uint64_t>(type);
+		switch (type) {
+		case JsonNodeType::VALUE_NUMBER_INT:
+		case JsonNodeType::VALUE_NUMBER_FLOAT: {
+			// Hash by value so 1 and 1.0 agree
+			double d = asDouble();
+			uint64_t bits;
+			std::memcpy(&bits, &d, sizeof(bits));
+			hash = hashMix(static_cast<uint64_t>(JsonNodeType::VALUE_NUMBER_FLOAT), d == 0.0 ? 0 : bits);
+		} break;
+		case JsonNodeType::VALUE_BOOLEAN:
+			hash = hashMix(hash, value.b);
+			break;
+		case JsonNodeType::VALUE_STRING:
+			hash = hashString(stringValue());
+			break;
+		case JsonNodeType::VALUE_ARRAY: {
+			if (cache.find(this, hash)) {
+				return hash;
+			}
+			if (maxDepth == 0) {
+				throw JsonException("Max depth exceeded while hashing Array node");
+			}
+			size_t start = cache.visit(value.array->size());
+			for (const auto& node : *value.array) {
+				hash = hashMix(hash, node.hash(maxDepth - 1, cache));
+			}
+			hash = hashFinalize(hash);
+			cache.store(this, hash, start);
+			return hash;
+		}
+		case JsonNodeType::VALUE_OBJECT: {
+			if (cache.find(this, hash)) {
+				return hash;
+			}
+			if (maxDepth == 0) {
+				throw JsonException("Max depth exceeded while hashing Object node");
+			}
+			// Summed so that key order does not matter
+			uint64_t sum = 0;
+			size_t start = cache.visit(value.object->size());
+			for (const auto& pair : *value.object) {
+				sum += hashFinalize(hashMix(hashString(pair.first), pair.second.hash(maxDepth - 1, cache)));
+			}
+			hash = hashFinalize(hashMix(hash, sum));
+			cache.store(this, hash, start);
+			return hash;
+		}
+		default:
+			break;
+		}
+		return hashFinalize(hash);
+	}
+	static uint64_t hashMix(uint64_t hash, uint64_t value) {
+		return hash ^ (value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2));
+	}
+	static uint64_t hashFinalize(uint64_t hash) {
+		hash ^= hash >> 33;
+		hash *= 0xff51afd7ed558ccdULL;
+		hash ^= hash >> 33;
+		hash *= 0xc4ceb9fe1a85ec53ULL;
+		hash ^= hash >> 33;
+		return hash;
+	}
+	static uint64_t hashString(const char* data, size_t size) {
+		uint64_t hash = 14695981039346656037ULL;
+		for (size_t i = 0; i < size; ++i) {
+			hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+		}
+		return hash;
+	}
+	static inline uint64_t hashString(const std::string& str) {
+		return hashString(str.data(), str.size());
+	}
 	void setType(JsonNodeType newType) {
 		switch (type) {
 		case JsonNodeType::VALUE_STRING:
-			value.str.~StrPtr();
+			if (pooled) {
+				pooled = false;
+			} else {
+				deleteNodeString(value.str.release());
+				value.str.~StrPtr();
+			}
 			break;
 		case JsonNodeType::VALUE_ARRAY:
 			value.array.~ArrayPtr();
@@ -624,6 +1224,117 @@ private:
 	}
 };
 
+// Remembers the hashes of the arrays and objects it has hashed, so that
+// hashing a tree and then its subtrees, or the same tree again, doesn't walk
+// them again.  Containers with fewer than minCachedNodes descendants are
+// cheaper to rehash than to look up, so they aren't kept.  Entries are keyed
+// by address, so the cache is only valid while the trees it has seen are
+// neither changed nor moved; clear it, or use a new one, after changing them.
+class JsonHashCache {
+public:
+	static const size_t minCachedNodes = 64;
+
+	uint64_t hash(const JsonNode& node, size_t maxDepth = 50) {
+		return node.hash(maxDepth, *this);
+	}
+
+	// Like JsonNode::deepEquals, but trees whose hashes differ are rejected
+	// without being walked, and so are any of their large subtrees
+	bool equal(const JsonNode& lhs, const JsonNode& rhs, size_t maxDepth = 50) {
+		if (hash(lhs, maxDepth) != hash(rhs, maxDepth)) {
+			return false;
+		}
+		return lhs.deepEquals(rhs, maxDepth, *this);
+	}
+
+	void clear() {
+		hashes.clear();
+		visited = 0;
+	}
+
+	size_t size() const {
+		return hashes.size();
+	}
+
+private:
+	friend class JsonNode;
+
+	std::unordered_map<const JsonNode*, uint64_t> hashes;
+	size_t visited = 0;
+
+	inline bool find(const JsonNode* node, uint64_t& hash) const {
+		auto it = hashes.find(node);
+		if (it == hashes.end()) {
+			return false;
+		}
+		hash = it->second;
+		return true;
+	}
+
+	// Returns the count before adding the children
+	inline size_t visit(size_t children) {
+		size_t start = visited;
+		visited += children;
+		return start;
+	}
+
+	inline void store(const JsonNode* node, uint64_t hash, size_t start) {
+		if (visited - start >= minCachedNodes) {
+			hashes[node] = hash;
+		}
+	}
+};
+
+// Looks one field up in many objects of the same shape.  The handle
+// remembers where it last found the field and checks there first, so
+// objects with the same field order need one string comparison.  A
+// handle shouldn't be shared between threads.
+class JsonFieldHandle {
+public:
+	explicit JsonFieldHandle(const std::string& key) : key(key) {
+	}
+
+	const std::string& getKey() const {
+		return key;
+	}
+
+	// Returns null if there is no such field.  A hit on the remembered
+	// index isn't checked against earlier fields, so if an object has the
+	// key more than once this may return a later copy than operator[]
+	// does.  Objects with unique keys always get the same field.
+	const JsonNode* find(const JsonNode& node) {
+		if (node.type != JsonNodeType::VALUE_OBJECT) {
+			return nullptr;
+		}
+		const JsonNode::Object& fields = *node.value.object;
+		if (hint < fields.size() && fields[hint].first.size() == key.size()
+				&& std::memcmp(fields[hint].first.data(), key.data(), key.size()) == 0) {
+			return &fields[hint].second;
+		}
+		size_t n = node.findField(key);
+		if (n == fields.size()) {
+			return nullptr;
+		}
+		hint = n;
+		return &fields[n].second;
+	}
+
+	inline JsonNode* find(JsonNode& node) {
+		return const_cast<JsonNode*>(find(static_cast<const JsonNode&>(node)));
+	}
+
+	// Returns a null node if there is no such field, like operator[]
+	const JsonNode& get(const JsonNode& node) {
+		static const JsonNode nullNode;
+		const JsonNode* field = find(node);
+		return field != nullptr ? *field : nullNode;
+	}
+
+private:
+	std::string key;
+	size_t hint = 0;
+};
+
 template <typename T>
 class JsonNodeIterator {
 public:
@@ -670,6 +1381,21 @@ inline JsonNodeIterator<T> end(T& node) {
 	return JsonNodeIterator<T>(&node, node.size());
 }
 
+inline void swap(JsonNode& lhs, JsonNode& rhs) noexcept {
+	lhs.swap(rhs);
+}
+
+}
+
+namespace std {
+
+template <>
+struct hash<jaxup::JsonNode> {
+	size_t operator()(const jaxup::JsonNode& node) const {
+		return static_cast<size_t>(node.hash());
+	}
+};
+
 }
 
 #endif
\ No newline at end of file
@@ -345,16 +345,17 @@ static inline void computeShortest(uint64_t minus, uint64_t mid, uint64_t plus,
 		}
 		if (minusIsTrailingZeroes) {
 			while (minus % 10 == 0) {
+				midIsTrailingZeroes &= lastRemovedDigit == 0;
 				lastRemovedDigit = mid % 10;
 				minus /= 10;
 				mid /= 10;
 				plus /= 10;
-				midIsTrailingZeroes &= lastRemovedDigit == 0;
 				++outExponent;
 			}
-			if (midIsTrailingZeroes && lastRemovedDigit == 5 && mid % 2 == 0) {
-				lastRemovedDigit = 4;
-			}
+		}
+		// Ties round to even
+		if (midIsTrailingZeroes && lastRemovedDigit == 5 && mid % 2 == 0) {
+			lastRemovedDigit = 4;
 		}
 		out = mid + ((mid == minus && (!even || !minusIsTrailingZeroes)) || lastRemovedDigit >= 5);
 		return;
@@ -378,9 +379,11 @@ static inline void computeShortest(uint64_t minus, uint64_t mid, uint64_t plus,
 	out = mid + (mid == minus || roundUp);
 }
 
-inline int conformalizeNumberString(char* buffer, char* integer, int length, int powTen) {
+// ECMAScript formatting (as required by RFC 8785) keeps plain notation up to
+// 21 integer digits and signs positive exponents
+inline int conformalizeNumberString(char* buffer, char* integer, int length, int powTen, bool ecmaScript = false) {
 	const int totalPowTen = length + powTen;
-	if (totalPowTen <= 19) {
+	if (totalPowTen <= (ecmaScript ? 21 : 19)) {
 		if (powTen >= 0) {
 			std::memcpy(buffer, integer, length);
 			// Whole number with no exponent
@@ -410,6 +413,18 @@ inline int conformalizeNumberString(char* buffer, char* integer, int length, int
 		}
 	}
 	// Use scientific notation
+	if (ecmaScript && totalPowTen > 0) {
+		int offset = 1;
+		buffer[0] = integer[0];
+		if (length > 1) {
+			buffer[1] = '.';
+			std::memcpy(buffer + 2, integer + 1, length - 1);
+			offset = length + 1;
+		}
+		buffer[offset] = 'e';
+		buffer[offset + 1] = '+';
+		return offset + 2 + writeSmallInteger(&buffer[offset + 2], totalPowTen - 1);
+	}
 	if (length == 1) {
 		buffer[0] = integer[0];
 		buffer[1] = 'e';
@@ -425,10 +440,15 @@ inline int conformalizeNumberString(char* buffer, char* integer, int length, int
 	}
 }
 
-inline int ryu(const double d, char* buffer) {
+inline int ryu(const double d, char* buffer, bool ecmaScript = false) {
+	if (ecmaScript && d == 0.0) {
+		// Negative zero is written as 0
+		buffer[0] = '0';
+		return 1;
+	}
 	if (std::signbit(d)) {
 		buffer[0] = '-';
-		return 1 + ryu(-d, buffer + 1);
+		return 1 + ryu(-d, buffer + 1, ecmaScript);
 	}
 	if (d == 0.0) {
 		buffer[0] = '0';
@@ -458,12 +478,12 @@ inline int ryu(const double d, char* buffer) {
 			decimalMinus, decimalMid, decimalPlus);
 
 		if (decimalExponent <= 21) {
-			if (binaryMinus % 5 == 0) {
+			if (binaryMid % 5 == 0) {
 				decimalMidIsTrailingZeros = isDivisibleByPowerOf5(binaryMid, decimalExponent);
 			} else if (even) {
 				decimalMinusIsTrailingZeros = isDivisibleByPowerOf5(binaryMinus, decimalExponent);
 			} else {
-				--decimalPlus;
+				decimalPlus -= isDivisibleByPowerOf5(binaryPlus, decimalExponent);
 			}
 		}
 	} else {
@@ -498,7 +518,7 @@ inline int ryu(const double d, char* buffer) {
 	char integerBuff[20];
 	char* start = writeIntegerToBuff(out, integerBuff + sizeof(integerBuff));
 	int length = static_cast<int>(sizeof(integerBuff) - (start - integerBuff));
-	return conformalizeNumberString(buffer, start, length, decimalExponent);
+	return conformalizeNumberString(buffer, start, length, decimalExponent, ecmaScript);
 }
 
 }
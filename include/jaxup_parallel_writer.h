@@ -0,0 +1,231 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#ifndef JAXUP_PARALLEL_WRITER_H
+#define JAXUP_PARALLEL_WRITER_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "jaxup_generator.h"
+#include "jaxup_node.h"
+#include "jaxup_thread_pool.h"
+
+namespace jaxup {
+
+// Serializes the children of large arrays/objects on a thread pool.  Runs of
+// children are written into separate buffers by the workers, then spliced into
+// the destination generator in their original order.  Output is byte for byte
+// identical to JsonNode::write, including with canonical generators, whose
+// object fields are written in sorted order.
+class JsonParallelWriter {
+public:
+	explicit JsonParallelWriter(JsonThreadPool& pool) : pool(pool) {
+	}
+
+	// Containers with fewer children are written on the calling thread,
+	// although their children are still considered for parallel writing.
+	JsonParallelWriter& setMinParallelSize(size_t newMinParallelSize) {
+		minParallelSize = std::max<size_t>(newMinParallelSize, 1);
+		return *this;
+	}
+
+	// Number of children per work item.  Zero picks a size based on the pool.
+	JsonParallelWriter& setChunkSize(size_t newChunkSize) {
+		chunkSize = newChunkSize;
+		return *this;
+	}
+
+	// Limits how many chunks may be buffered ahead of the one being written.
+	JsonParallelWriter& setMaxChunksInFlight(size_t newMaxChunksInFlight) {
+		maxChunksInFlight = newMaxChunksInFlight;
+		return *this;
+	}
+
+	template <class dest>
+	void write(const JsonNode& node, JsonGenerator<dest>& generator, size_t maxDepth = 50) {
+		JsonNodeType type = node.getType();
+		if (type != JsonNodeType::VALUE_ARRAY && type != JsonNodeType::VALUE_OBJECT) {
+			node.write(generator, maxDepth);
+			return;
+		}
+		if (maxDepth == 0) {
+			throw JsonException("Max depth exceeded while writing ", getNodeTypeAsString(type), " node");
+		}
+		// Indexes of the fields in the order they're written, when that
+		// isn't the node's order
+		std::vector<size_t> order;
+		if (type == JsonNodeType::VALUE_OBJECT && generator.isCanonical()) {
+			order.resize(node.size());
+			for (size_t i = 0; i < order.size(); ++i) {
+				order[i] = i;
+			}
+			std::sort(order.begin(), order.end(), [&node](size_t a, size_t b) {
+				return compareUtf16(node.getField(a).first, node.getField(b).first) < 0;
+			});
+		}
+		if (type == JsonNodeType::VALUE_ARRAY) {
+			generator.startArray();
+		} else {
+			generator.startObject();
+		}
+		if (node.size() >= minParallelSize) {
+			writeChildrenParallel(node, order, generator, maxDepth - 1);
+		} else {
+			for (size_t i = 0; i < node.size(); ++i) {
+				if (type == JsonNodeType::VALUE_OBJECT) {
+					auto field = node.getField(order.empty() ? i : order[i]);
+					generator.writeFieldName(field.first);
+					write(field.second, generator, maxDepth - 1);
+				} else {
+					write(node[i], generator, maxDepth - 1);
+				}
+			}
+		}
+		if (type == JsonNodeType::VALUE_ARRAY) {
+			generator.endArray();
+		} else {
+			generator.endObject();
+		}
+	}
+
+private:
+	struct Chunk {
+		std::string data;
+		std::vector<size_t> ends;
+		std::exception_ptr error;
+		bool done = false;
+	};
+
+	JsonThreadPool& pool;
+	size_t minParallelSize = 1024;
+	size_t chunkSize = 0;
+	size_t maxChunksInFlight = 0;
+	std::mutex mutex;
+	std::condition_variable chunkDone;
+
+	static const JsonNode& childAt(const JsonNode& node, const std::vector<size_t>& order, size_t i) {
+		if (node.getType() == JsonNodeType::VALUE_OBJECT) {
+			return node.getField(order.empty() ? i : order[i]).second;
+		}
+		return node[i];
+	}
+
+	void serializeChunk(const JsonNode& node, const std::vector<size_t>& order, size_t begin, size_t end, bool prettyPrint,
+		bool canonical, size_t indentDepth, size_t maxDepth, Chunk& chunk) {
+		try {
+			JsonGenerator<std::string> generator(chunk.data, prettyPrint, indentDepth);
+			generator.setCanonical(canonical);
+			chunk.ends.reserve(end - begin);
+			for (size_t i = begin; i < end; ++i) {
+				childAt(node, order, i).write(generator, maxDepth);
+				generator.flush();
+				chunk.ends.push_back(chunk.data.size());
+			}
+		} catch (...) {
+			chunk.error = std::current_exception();
+		}
+		// Notified under the lock, since the writer may return and destroy
+		// the condition variable as soon as it sees the last chunk done
+		std::lock_guard<std::mutex> lock(mutex);
+		chunk.done = true;
+		chunkDone.notify_all();
+	}
+
+	template <class dest>
+	void writeChildrenParallel(const JsonNode& node, const std::vector<size_t>& order, JsonGenerator<dest>& generator, size_t maxDepth) {
+		const size_t numChildren = node.size();
+		size_t perChunk = chunkSize;
+		if (perChunk == 0) {
+			perChunk = std::max<size_t>(1, std::min<size_t>(4096, numChildren / (pool.size() * 16)));
+		}
+		const size_t numChunks = (numChildren + perChunk - 1) / perChunk;
+		size_t inFlight = maxChunksInFlight;
+		if (inFlight == 0) {
+			inFlight = pool.size() * 4;
+		}
+		const bool prettyPrint = generator.isPrettyPrint();
+		const bool canonical = generator.isCanonical();
+		const size_t indentDepth = generator.getDepth();
+		const bool isObject = node.getType() == JsonNodeType::VALUE_OBJECT;
+
+		std::vector<std::unique_ptr<Chunk>> chunks(numChunks);
+		size_t submitted = 0;
+		auto submitNext = [&]() {
+			size_t begin = submitted * perChunk;
+			size_t end = std::min(begin + perChunk, numChildren);
+			chunks[submitted].reset(new Chunk);
+			Chunk* chunk = chunks[submitted].get();
+			pool.submit([this, &node, &order, begin, end, prettyPrint, canonical, indentDepth, maxDepth, chunk]() {
+				serializeChunk(node, order, begin, end, prettyPrint, canonical, indentDepth, maxDepth, *chunk);
+			});
+			++submitted;
+		};
+
+		std::exception_ptr error;
+		for (size_t i = 0; i < numChunks; ++i) {
+			while (submitted < numChunks && submitted < i + inFlight && !error) {
+				submitNext();
+			}
+			if (!chunks[i]) {
+				break;
+			}
+			Chunk& chunk = *chunks[i];
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				chunkDone.wait(lock, [&chunk]() { return chunk.done; });
+			}
+			if (chunk.error && !error) {
+				error = chunk.error;
+			}
+			if (!error) {
+				try {
+					size_t start = 0;
+					for (size_t j = 0; j < chunk.ends.size(); ++j) {
+						if (isObject) {
+							size_t field = i * perChunk + j;
+							generator.writeFieldName(node.getField(order.empty() ? field : order[field]).first);
+						}
+						generator.writeRawValue(chunk.data.data() + start, chunk.ends[j] - start);
+						start = chunk.ends[j];
+					}
+				} catch (...) {
+					// Still have to wait for the outstanding chunks before bailing
+					error = std::current_exception();
+				}
+			}
+			chunks[i].reset();
+		}
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+};
+}
+
+#endif
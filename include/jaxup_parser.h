@@ -23,7 +23,10 @@
 #ifndef JAXUP_PARSER_H
 #define JAXUP_PARSER_H
 
+#include <algorithm>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <vector>
 
@@ -39,18 +42,26 @@ class JsonSource {
 template <size_t size>
 class JsonSource<std::istream, size> {
 public:
-	JsonSource(std::istream& input) : input(input) {
+	JsonSource(std::istream& input) : input(&input) {
+	}
+	inline void reset(std::istream& newInput) {
+		input = &newInput;
 	}
 	inline size_t loadMore(char inputBuffer[size]) {
-		if (input.eof() || input.bad()) {
+		if (input->eof() || input->bad()) {
 			return 0;
 		}
-		input.read(&inputBuffer[0], size);
-		return static_cast<size_t>(input.gcount());
+		input->read(&inputBuffer[0], size);
+		return static_cast<size_t>(input->gcount());
+	}
+	inline bool seek(uint64_t offset) {
+		input->clear();
+		input->seekg(static_cast<std::streamoff>(offset));
+		return !input->fail();
 	}
 
 private:
-	std::istream& input;
+	std::istream* input;
 };
 
 template <size_t size>
@@ -58,17 +69,72 @@ class JsonSource<FILE*, size> {
 public:
 	JsonSource(FILE* input) : input(input) {
 	}
+	inline void reset(FILE* newInput) {
+		input = newInput;
+	}
 	inline size_t loadMore(char inputBuffer[size]) {
 		if (input == nullptr) {
 			return 0;
 		}
 		return fread(&inputBuffer[0], 1, size, input);
 	}
+	inline bool seek(uint64_t offset) {
+		if (input == nullptr) {
+			return false;
+		}
+#ifdef _WIN32
+		return _fseeki64(input, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+		return fseeko(input, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+	}
 
 private:
 	FILE* input;
 };
 
+// Reads from a string in memory, which must outlive the parser.
+template <size_t size>
+class JsonSource<std::string, size> {
+public:
+	JsonSource(std::string& input) : input(&input) {
+	}
+	inline void reset(std::string& newInput) {
+		input = &newInput;
+		position = 0;
+	}
+	inline size_t loadMore(char inputBuffer[size]) {
+		size_t count = std::min<size_t>(size, input->size() - position);
+		std::memcpy(&inputBuffer[0], input->data() + position, count);
+		position += count;
+		return count;
+	}
+	inline bool seek(uint64_t offset) {
+		if (offset > input->size()) {
+			return false;
+		}
+		position = static_cast<size_t>(offset);
+		return true;
+	}
+
+private:
+	std::string* input;
+	size_t position = 0;
+};
+
+// Everything needed to resume parsing where a parser left off.  See
+// JsonParser::checkpoint and JsonParser::restore.
+struct JsonParserState {
+	uint64_t byteOffset = 0;
+	uint64_t tokenByteOffset = 0;
+	JsonToken token = JsonToken::NOT_AVAILABLE;
+	std::vector<JsonToken> tagStack;
+	std::string currentName;
+	std::string currentString;
+	int64_t integerValue = 0;
+	double doubleValue = 0.0;
+};
+
 static inline int getIntFromChar(char c) {
 	return c - '0';
 }
@@ -81,6 +147,8 @@ private:
 	JsonToken token = JsonToken::NOT_AVAILABLE;
 	int inputOffset = 0;
 	int inputSize = 0;
+	uint64_t bufferStart = 0;
+	uint64_t tokenStart = 0;
 	char inputBuffer[initialBuffSize];
 	std::string currentName, currentString;
 	std::vector<JsonToken> tagStack;
@@ -94,6 +162,87 @@ public:
 	}
 	~JsonParser() = default;
 
+	// Rebinds the parser to a new input and discards all parsing state, allowing
+	// a single parser (and its buffers) to be reused across documents.
+	void reset(source& newInput) {
+		input.reset(newInput);
+		int64Value = 0;
+		doubleValue = 0.0;
+		token = JsonToken::NOT_AVAILABLE;
+		inputOffset = 0;
+		inputSize = 0;
+		bufferStart = 0;
+		tokenStart = 0;
+		currentName.clear();
+		currentString.clear();
+		tagStack.clear();
+	}
+
+	// Repositions the parser at an absolute byte offset in its input.  By default
+	// parsing resumes at the root level; with insideArray set, it resumes as
+	// though the parser had just entered a top level array, so the next call to
+	// nextToken reads an array element.
+	void seek(uint64_t byteOffset, bool insideArray = false) {
+		if (!input.seek(byteOffset)) {
+			throw JsonException("Failed to seek in the input stream");
+		}
+		token = JsonToken::NOT_AVAILABLE;
+		inputOffset = 0;
+		inputSize = 0;
+		bufferStart = byteOffset;
+		tokenStart = byteOffset;
+		tagStack.clear();
+		if (insideArray) {
+			tagStack.push_back(JsonToken::START_ARRAY);
+			token = JsonToken::START_ARRAY;
+		}
+	}
+
+	// Captures the parser's position, including the current token and its
+	// value.  Restoring it later, even into a different parser over the same
+	// data, resumes parsing with the token that would have come next.
+	void checkpoint(JsonParserState& state) const {
+		state.byteOffset = getCurrentByteOffset();
+		state.tokenByteOffset = tokenStart;
+		state.token = token;
+		state.tagStack = tagStack;
+		state.currentName = currentName;
+		state.currentString = currentString;
+		state.integerValue = int64Value;
+		state.doubleValue = doubleValue;
+	}
+
+	JsonParserState checkpoint() const {
+		JsonParserState state;
+		checkpoint(state);
+		return state;
+	}
+
+	void restore(const JsonParserState& state) {
+		seek(state.byteOffset);
+		tokenStart = state.tokenByteOffset;
+		token = state.token;
+		tagStack = state.tagStack;
+		currentName = state.currentName;
+		currentString = state.currentString;
+		int64Value = state.integerValue;
+		doubleValue = state.doubleValue;
+	}
+
+	// Offset of the first byte of the current token
+	uint64_t getTokenByteOffset() const {
+		return tokenStart;
+	}
+
+	// Offset of the first byte that hasn't been consumed yet
+	uint64_t getCurrentByteOffset() const {
+		return bufferStart + static_cast<uint64_t>(inputOffset);
+	}
+
+	size_t getDepth() const {
+		return tagStack.size();
+	}
+
 	JsonToken currentToken() const {
 		return this->token;
 	}
@@ -148,6 +297,160 @@ public:
 		return *this;
 	}
 
+	// Like skipChildren, but scans raw bytes for the matching close rather than
+	// tokenizing the contents, which are therefore not validated.  Optionally
+	// reports how deeply nested the skipped value was, and appends the bytes
+	// after the opening bracket up to and including the closing one to raw.
+	JsonParser& fastSkipChildren(size_t* maxDepth = nullptr, std::string* raw = nullptr) {
+		if (this->token != JsonToken::START_OBJECT && this->token != JsonToken::START_ARRAY) {
+			if (maxDepth != nullptr) {
+				*maxDepth = 0;
+			}
+			return *this;
+		}
+		size_t depth = 1;
+		size_t deepest = 1;
+		bool inString = false;
+		bool escaped = false;
+		char c = 0;
+		int runStart = inputOffset;
+		while (depth > 0) {
+			if (inputOffset > inputSize - 1) {
+				if (raw != nullptr) {
+					raw->append(&inputBuffer[runStart], inputOffset - runStart);
+				}
+				if (!loadMore()) {
+					if (escaped) {
+						throw JsonException("String was not terminated");
+					}
+					throw JsonException(this->token == JsonToken::START_OBJECT ? "Failed to close object at end of stream" : "Failed to close array at end of stream");
+				}
+				runStart = inputOffset;
+			}
+			c = inputBuffer[inputOffset++];
+			if (inString) {
+				if (escaped) {
+					escaped = false;
+				} else if (c == '"') {
+					inString = false;
+				} else if (c == '\\') {
+					escaped = true;
+				}
+				continue;
+			}
+			switch (c) {
+			case '"':
+				inString = true;
+				break;
+			case '{':
+			case '[':
+				if (++depth > deepest) {
+					deepest = depth;
+				}
+				break;
+			case '}':
+			case ']':
+				--depth;
+				break;
+			default:
+				break;
+			}
+		}
+		if (raw != nullptr) {
+			raw->append(&inputBuffer[runStart], inputOffset - runStart);
+		}
+		tokenStart = getCurrentByteOffset() - 1;
+		if (c == '}') {
+			parseCloseObject();
+		} else {
+			parseCloseArray();
+		}
+		if (maxDepth != nullptr) {
+			*maxDepth = deepest;
+		}
+		return *this;
+	}
+
+	// Skips the value after the current field name without tokenizing it:
+	// numbers aren't converted, strings aren't copied and containers are
+	// skipped as in fastSkipChildren.  The parser is left on a token of the
+	// skipped value's type (or the container's end token), though its value
+	// can't be read.  Anywhere else it simply reads and skips the next value.
+	JsonToken skipNextValue() {
+		if (this->token != JsonToken::FIELD_NAME) {
+			nextToken();
+			fastSkipChildren();
+			return this->token;
+		}
+		char c;
+		getNextSignificantCharacter(&c);
+		if (c != ':') {
+			throw JsonException("Expected a colon, but none was found");
+		}
+		getNextSignificantCharacter(&c);
+		markTokenStart();
+		switch (c) {
+		case '"':
+			for (;;) {
+				if (inputOffset > inputSize - 1 && !loadMore()) {
+					throw JsonException("String was not terminated");
+				}
+				c = inputBuffer[inputOffset++];
+				if (c == '"') {
+					break;
+				}
+				if (c == '\\' && !readNextCharacter(&c)) {
+					throw JsonException("String was not terminated");
+				}
+			}
+			currentString.clear();
+			return foundToken(JsonToken::VALUE_STRING);
+		case '{':
+		case '[':
+			tagStack.push_back(c == '{' ? JsonToken::START_OBJECT : JsonToken::START_ARRAY);
+			foundToken(tagStack.back());
+			fastSkipChildren();
+			return this->token;
+		case '-':
+		case '0':
+		case '1':
+		case '2':
+		case '3':
+		case '4':
+		case '5':
+		case '6':
+		case '7':
+		case '8':
+		case '9': {
+			bool isFloat = false;
+			while (peekNextCharacter(&c) && !isDelimiter(c)) {
+				isFloat |= c == '.' || c == 'e' || c == 'E';
+				++inputOffset;
+			}
+			int64Value = 0;
+			doubleValue = 0.0;
+			return foundToken(isFloat ? JsonToken::VALUE_NUMBER_FLOAT : JsonToken::VALUE_NUMBER_INT);
+		}
+		case 't':
+			if (!nextEquals("rue", 3)) {
+				throw JsonException("Invalid token beginning with t");
+			}
+			return foundToken(JsonToken::VALUE_TRUE);
+		case 'f':
+			if (!nextEquals("alse", 4)) {
+				throw JsonException("Invalid token beginning with f");
+			}
+			return foundToken(JsonToken::VALUE_FALSE);
+		case 'n':
+			if (!nextEquals("ull", 3)) {
+				throw JsonException("Invalid token beginning with n");
+			}
+			return foundToken(JsonToken::VALUE_NULL);
+		default:
+			throw JsonException("Invalid token beginning with character: ", std::string(&c, 1));
+		}
+	}
+
 	JsonToken nextToken() {
 		char c;
 		bool comma = false;
@@ -159,6 +462,7 @@ public:
 		} else if (!this->tagStack.empty() && this->token != JsonToken::START_ARRAY && this->token != JsonToken::START_OBJECT) {
 			// Expect a comma or a close array/object
 			getNextSignificantCharacter(&c);
+			markTokenStart();
 			switch (c) {
 			case ']':
 				return parseCloseArray();
@@ -175,6 +479,7 @@ public:
 
 		if (this->token != JsonToken::FIELD_NAME && !this->tagStack.empty() && this->tagStack.back() == JsonToken::START_OBJECT) {
 			getNextSignificantCharacter(&c);
+			markTokenStart();
 			if (c == '}') {
 				return parseCloseObject(comma);
 			}
@@ -189,6 +494,7 @@ public:
 		while (readNextCharacter(&c)) {
 			if (isInsignificantWhitespace(c))
 				continue;
+			markTokenStart();
 			switch (c) {
 			case '-':
 				return parseNegativeNumber();
@@ -308,6 +614,17 @@ private:
 					} else if (code < 0x800) {
 						buff.push_back(0xC0 | (char)(code >> 6));
 						buff.push_back(0x80 | (char)(code & 0x3F));
+					} else if (code >= 0xDC00 && code <= 0xDFFF && buff.size() >= 3
+						&& (unsigned char)buff[buff.size() - 3] == 0xED && (buff[buff.size() - 2] & 0xF0) == 0xA0) {
+						// Second half of a surrogate pair, so combine it with the first
+						const size_t first = buff.size() - 3;
+						long high = ((buff[first + 1] & 0x0F) << 6) | (buff[first + 2] & 0x3F);
+						code = 0x10000 + (high << 10) + (code - 0xDC00);
+						buff.resize(first);
+						buff.push_back(0xF0 | (char)(code >> 18));
+						buff.push_back(0x80 | (char)((code >> 12) & 0x3F));
+						buff.push_back(0x80 | (char)((code >> 6) & 0x3F));
+						buff.push_back(0x80 | (char)(code & 0x3F));
 					} else {
 						buff.push_back(0xE0 | (char)(code >> 12));
 						buff.push_back(0x80 | (char)((code >> 6) & 0x3F));
@@ -527,6 +844,7 @@ private:
 	}
 
 	inline bool loadMore() {
+		bufferStart += static_cast<uint64_t>(inputSize);
 		inputOffset = 0;
 		inputSize = static_cast<int>(input.loadMore(inputBuffer));
 		return inputSize > 0;
@@ -564,6 +882,10 @@ private:
 			;
 	}
 
+	inline void markTokenStart() {
+		tokenStart = getCurrentByteOffset() - 1;
+	}
+
 	inline JsonToken foundToken(JsonToken found) {
 		this->token = found;
 		return found;
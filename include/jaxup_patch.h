@@ -0,0 +1,842 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+
+#ifndef JAXUP_PATCH_H
+#define JAXUP_PATCH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "jaxup_common.h"
+#include "jaxup_generator.h"
+#include "jaxup_node.h"
+#include "jaxup_parser.h"
+
+namespace jaxup {
+
+// Appends a reference token to a JSON Pointer (RFC 6901)
+inline void appendJsonPointerToken(std::string& pointer, const std::string& token) {
+	pointer += '/';
+	for (char c : token) {
+		if (c == '~') {
+			pointer += "~0";
+		} else if (c == '/') {
+			pointer += "~1";
+		} else {
+			pointer += c;
+		}
+	}
+}
+
+inline std::vector<std::string> parseJsonPointer(const std::string& pointer) {
+	std::vector<std::string> tokens;
+	if (pointer.empty()) {
+		return tokens;
+	}
+	if (pointer[0] != '/') {
+		throw JsonException("JSON Pointer must start with a slash: ", pointer);
+	}
+	for (size_t i = 0; i < pointer.size(); ++i) {
+		char c = pointer[i];
+		if (c == '/') {
+			tokens.emplace_back();
+		} else if (c == '~') {
+			if (i + 1 == pointer.size() || (pointer[i + 1] != '0' && pointer[i + 1] != '1')) {
+				throw JsonException("Invalid escape in JSON Pointer: ", pointer);
+			}
+			tokens.back() += pointer[++i] == '0' ? '~' : '/';
+		} else {
+			tokens.back() += c;
+		}
+	}
+	return tokens;
+}
+
+// Produces and applies JSON Patch (RFC 6902) documents.  Objects compare
+// regardless of key order, and numbers compare by value.
+class JsonPatch {
+public:
+	// Returns an array of operations that turns from into to.  Container
+	// hashes are cached for the length of the diff, so identical subtrees are
+	// recognized without being walked more than once, and array elements are
+	// aligned by a longest common subsequence over their hashes.
+	static JsonNode diff(const JsonNode& from, const JsonNode& to, size_t maxDepth = 50) {
+		JsonPatch patch;
+		JsonNode operations;
+		operations.makeArray();
+		std::string path;
+		patch.diffNodes(from, to, path, operations, maxDepth);
+		return operations;
+	}
+
+	// Applies the operations in order.  Throws if one fails, in which case
+	// the operations before it remain applied.
+	static void apply(JsonNode& target, const JsonNode& operations, size_t maxDepth = 50) {
+		if (operations.getType() != JsonNodeType::VALUE_ARRAY) {
+			throw JsonException("A JSON Patch must be an array of operations");
+		}
+		for (size_t i = 0; i < operations.size(); ++i) {
+			applyOperation(target, operations[i], maxDepth);
+		}
+	}
+
+private:
+	// Arrays whose differing middles need more cells than this are compared
+	// position by position instead
+	static const size_t maxLcsCells = 1 << 22;
+	static const size_t noAnchor = static_cast<size_t>(-1);
+
+	JsonHashCache hashes;
+
+	static void addOperation(JsonNode& operations, const char* op, const std::string& path, const JsonNode* value) {
+		JsonNode& operation = operations.append();
+		operation["op"] = op;
+		operation["path"] = path;
+		if (value != nullptr) {
+			value->copyTo(operation["value"]);
+		}
+	}
+
+	// Objects with different hashes can't be equal.  Arrays are compared
+	// directly, since aligning them hashes their elements anyway.
+	bool equal(const JsonNode& lhs, const JsonNode& rhs, size_t maxDepth) {
+		if (lhs.getType() == JsonNodeType::VALUE_OBJECT && rhs.getType() == JsonNodeType::VALUE_OBJECT) {
+			return hashes.equal(lhs, rhs, maxDepth);
+		}
+		return lhs.deepEquals(rhs, maxDepth);
+	}
+
+	void diffNodes(const JsonNode& from, const JsonNode& to, std::string& path, JsonNode& operations, size_t maxDepth) {
+		if (equal(from, to, maxDepth)) {
+			return;
+		}
+		if (from.getType() != to.getType() || maxDepth == 0) {
+			addOperation(operations, "replace", path, &to);
+		} else if (from.getType() == JsonNodeType::VALUE_OBJECT) {
+			diffObjects(from, to, path, operations, maxDepth);
+		} else if (from.getType() == JsonNodeType::VALUE_ARRAY) {
+			diffArrays(from, to, path, operations, maxDepth);
+		} else {
+			addOperation(operations, "replace", path, &to);
+		}
+	}
+
+	void diffObjects(const JsonNode& from, const JsonNode& to, std::string& path, JsonNode& operations, size_t maxDepth) {
+		std::unordered_map<std::string, size_t> toIndex;
+		toIndex.reserve(to.size());
+		for (size_t i = 0; i < to.size(); ++i) {
+			toIndex.emplace(to.getField(i).first, i);
+		}
+		const size_t length = path.size();
+		std::vector<bool> matched(to.size(), false);
+		for (size_t i = 0; i < from.size(); ++i) {
+			auto field = from.getField(i);
+			appendJsonPointerToken(path, field.first);
+			auto it = toIndex.find(field.first);
+			if (it == toIndex.end()) {
+				addOperation(operations, "remove", path, nullptr);
+			} else {
+				matched[it->second] = true;
+				diffNodes(field.second, to.getField(it->second).second, path, operations, maxDepth - 1);
+			}
+			path.resize(length);
+		}
+		for (size_t i = 0; i < to.size(); ++i) {
+			if (!matched[i]) {
+				auto field = to.getField(i);
+				appendJsonPointerToken(path, field.first);
+				addOperation(operations, "add", path, &field.second);
+				path.resize(length);
+			}
+		}
+	}
+
+	void diffArrays(const JsonNode& from, const JsonNode& to, std::string& path, JsonNode& operations, size_t maxDepth) {
+		size_t position = 0;
+		align(from, 0, from.size(), to, 0, to.size(), position, path, operations, maxDepth);
+	}
+
+	// Aligns from[fromStart, fromStart + n) with to[toStart, toStart + m).
+	// Small ranges use a longest common subsequence; large ones are split at
+	// elements that occur exactly once on both sides, keeping the longest
+	// run of such anchors that appear in the same order.
+	void align(const JsonNode& from, size_t fromStart, size_t n, const JsonNode& to, size_t toStart, size_t m,
+			size_t& position, std::string& path, JsonNode& operations, size_t maxDepth) {
+		while (n > 0 && m > 0 && from[fromStart].deepEquals(to[toStart], maxDepth - 1)) {
+			++fromStart;
+			++toStart;
+			--n;
+			--m;
+			++position;
+		}
+		size_t suffix = 0;
+		while (suffix < n && suffix < m && from[fromStart + n - 1 - suffix].deepEquals(to[toStart + m - 1 - suffix], maxDepth - 1)) {
+			++suffix;
+		}
+		n -= suffix;
+		m -= suffix;
+		if (n == 0 || m == 0) {
+			diffRun(from, fromStart, n, to, toStart, m, position, path, operations, maxDepth);
+		} else if ((n + 1) * (m + 1) <= maxLcsCells) {
+			alignLcs(from, fromStart, n, to, toStart, m, position, path, operations, maxDepth);
+		} else {
+			alignAnchors(from, fromStart, n, to, toStart, m, position, path, operations, maxDepth);
+		}
+		position += suffix;
+	}
+
+	void alignLcs(const JsonNode& from, size_t fromStart, size_t n, const JsonNode& to, size_t toStart, size_t m,
+			size_t& position, std::string& path, JsonNode& operations, size_t maxDepth) {
+		// lcs[i][j] is the length of the longest common subsequence of the
+		// suffixes starting at i and j
+		std::vector<uint64_t> fromHashes(n);
+		std::vector<uint64_t> toHashes(m);
+		for (size_t i = 0; i < n; ++i) {
+			fromHashes[i] = hashes.hash(from[fromStart + i], maxDepth - 1);
+		}
+		for (size_t j = 0; j < m; ++j) {
+			toHashes[j] = hashes.hash(to[toStart + j], maxDepth - 1);
+		}
+		std::vector<uint32_t> lcs((n + 1) * (m + 1), 0);
+		for (size_t i = n; i-- > 0;) {
+			for (size_t j = m; j-- > 0;) {
+				if (fromHashes[i] == toHashes[j]) {
+					lcs[i * (m + 1) + j] = lcs[(i + 1) * (m + 1) + j + 1] + 1;
+				} else {
+					lcs[i * (m + 1) + j] = std::max(lcs[(i + 1) * (m + 1) + j], lcs[i * (m + 1) + j + 1]);
+				}
+			}
+		}
+		size_t i = 0;
+		size_t j = 0;
+		size_t runFrom = 0;
+		size_t runTo = 0;
+		while (i < n || j < m) {
+			if (i < n && j < m && fromHashes[i] == toHashes[j] && from[fromStart + i].deepEquals(to[toStart + j], maxDepth - 1)) {
+				diffRun(from, fromStart + runFrom, i - runFrom, to, toStart + runTo, j - runTo, position, path, operations, maxDepth);
+				++i;
+				++j;
+				++position;
+				runFrom = i;
+				runTo = j;
+			} else if (j == m || (i < n && lcs[(i + 1) * (m + 1) + j] >= lcs[i * (m + 1) + j + 1])) {
+				++i;
+			} else {
+				++j;
+			}
+		}
+		diffRun(from, fromStart + runFrom, n - runFrom, to, toStart + runTo, m - runTo, position, path, operations, maxDepth);
+	}
+
+	void alignAnchors(const JsonNode& from, size_t fromStart, size_t n, const JsonNode& to, size_t toStart, size_t m,
+			size_t& position, std::string& path, JsonNode& operations, size_t maxDepth) {
+		struct Occurrences {
+			size_t fromCount = 0;
+			size_t toCount = 0;
+			size_t fromIndex = 0;
+			size_t toIndex = 0;
+		};
+		std::unordered_map<uint64_t, Occurrences> occurrences;
+		occurrences.reserve(n + m);
+		std::vector<uint64_t> fromHashes(n);
+		for (size_t i = 0; i < n; ++i) {
+			fromHashes[i] = hashes.hash(from[fromStart + i], maxDepth - 1);
+			Occurrences& entry = occurrences[fromHashes[i]];
+			++entry.fromCount;
+			entry.fromIndex = i;
+		}
+		for (size_t j = 0; j < m; ++j) {
+			auto it = occurrences.find(hashes.hash(to[toStart + j], maxDepth - 1));
+			if (it != occurrences.end()) {
+				++it->second.toCount;
+				it->second.toIndex = j;
+			}
+		}
+		// Unique pairs in from order, then the longest run increasing in to
+		std::vector<std::pair<size_t, size_t>> pairs;
+		for (size_t i = 0; i < n; ++i) {
+			const Occurrences& entry = occurrences.at(fromHashes[i]);
+			if (entry.fromCount == 1 && entry.toCount == 1 && from[fromStart + i].deepEquals(to[toStart + entry.toIndex], maxDepth - 1)) {
+				pairs.emplace_back(i, entry.toIndex);
+			}
+		}
+		std::vector<size_t> tails;
+		std::vector<size_t> previous(pairs.size(), static_cast<size_t>(noAnchor));
+		for (size_t k = 0; k < pairs.size(); ++k) {
+			auto it = std::lower_bound(tails.begin(), tails.end(), pairs[k].second, [&pairs](size_t t, size_t value) {
+				return pairs[t].second < value;
+			});
+			if (it != tails.begin()) {
+				previous[k] = *(it - 1);
+			}
+			if (it == tails.end()) {
+				tails.push_back(k);
+			} else {
+				*it = k;
+			}
+		}
+		std::vector<size_t> anchors;
+		for (size_t k = tails.empty() ? noAnchor : tails.back(); k != noAnchor; k = previous[k]) {
+			anchors.push_back(k);
+		}
+		if (anchors.empty()) {
+			diffRun(from, fromStart, n, to, toStart, m, position, path, operations, maxDepth);
+			return;
+		}
+		size_t i = 0;
+		size_t j = 0;
+		for (size_t a = anchors.size(); a-- > 0;) {
+			const auto& anchor = pairs[anchors[a]];
+			align(from, fromStart + i, anchor.first - i, to, toStart + j, anchor.second - j, position, path, operations, maxDepth);
+			++position;
+			i = anchor.first + 1;
+			j = anchor.second + 1;
+		}
+		align(from, fromStart + i, n - i, to, toStart + j, m - j, position, path, operations, maxDepth);
+	}
+
+	// Turns a run of n elements into m others: pairs are diffed in place, then
+	// the surplus is removed or added
+	void diffRun(const JsonNode& from, size_t fromStart, size_t n, const JsonNode& to, size_t toStart, size_t m,
+			size_t& position, std::string& path, JsonNode& operations, size_t maxDepth) {
+		const size_t length = path.size();
+		const size_t paired = std::min(n, m);
+		for (size_t k = 0; k < paired; ++k) {
+			appendJsonPointerToken(path, std::to_string(position++));
+			diffNodes(from[fromStart + k], to[toStart + k], path, operations, maxDepth - 1);
+			path.resize(length);
+		}
+		for (size_t k = paired; k < n; ++k) {
+			appendJsonPointerToken(path, std::to_string(position));
+			addOperation(operations, "remove", path, nullptr);
+			path.resize(length);
+		}
+		for (size_t k = paired; k < m; ++k) {
+			appendJsonPointerToken(path, std::to_string(position++));
+			addOperation(operations, "add", path, &to[toStart + k]);
+			path.resize(length);
+		}
+	}
+
+	// The index must be below size, or at most size when adding
+	static size_t parseIndex(const std::string& token, size_t size, bool adding = false) {
+		if (token.empty() || (token.size() > 1 && token[0] == '0') || token.size() > 18) {
+			throw JsonException("Invalid array index in JSON Pointer: ", token);
+		}
+		size_t index = 0;
+		for (char c : token) {
+			if (c < '0' || c > '9') {
+				throw JsonException("Invalid array index in JSON Pointer: ", token);
+			}
+			index = index * 10 + (c - '0');
+		}
+		if (index > size || (index == size && !adding)) {
+			throw JsonException("Array index out of range in JSON Pointer: ", token);
+		}
+		return index;
+	}
+
+	// Resolves all but the last token of the pointer
+	static JsonNode& resolveParent(JsonNode& target, const std::vector<std::string>& tokens) {
+		JsonNode* node = &target;
+		for (size_t i = 0; i + 1 < tokens.size(); ++i) {
+			if (node->getType() == JsonNodeType::VALUE_OBJECT) {
+				node = node->find(tokens[i]);
+				if (node == nullptr) {
+					throw JsonException("JSON Pointer refers to a missing field: ", tokens[i]);
+				}
+			} else if (node->getType() == JsonNodeType::VALUE_ARRAY) {
+				node = &(*node)[parseIndex(tokens[i], node->size())];
+			} else {
+				throw JsonException("JSON Pointer descends into a scalar at: ", tokens[i]);
+			}
+		}
+		return *node;
+	}
+
+	static JsonNode& resolve(JsonNode& target, const std::vector<std::string>& tokens) {
+		if (tokens.empty()) {
+			return target;
+		}
+		JsonNode& parent = resolveParent(target, tokens);
+		if (parent.getType() == JsonNodeType::VALUE_ARRAY) {
+			return parent[parseIndex(tokens.back(), parent.size())];
+		}
+		JsonNode* node = parent.find(tokens.back());
+		if (node == nullptr) {
+			throw JsonException("JSON Pointer refers to a missing value: ", tokens.back());
+		}
+		return *node;
+	}
+
+	static void add(JsonNode& target, const std::vector<std::string>& tokens, JsonNode& value) {
+		if (tokens.empty()) {
+			target = std::move(value);
+			return;
+		}
+		JsonNode& parent = resolveParent(target, tokens);
+		if (parent.getType() == JsonNodeType::VALUE_OBJECT) {
+			parent[tokens.back()] = std::move(value);
+		} else if (parent.getType() == JsonNodeType::VALUE_ARRAY) {
+			if (tokens.back() == "-") {
+				parent.append() = std::move(value);
+			} else {
+				parent.insert(parseIndex(tokens.back(), parent.size(), true)) = std::move(value);
+			}
+		} else {
+			throw JsonException("JSON Patch cannot add to a scalar");
+		}
+	}
+
+	static void remove(JsonNode& target, const std::vector<std::string>& tokens) {
+		if (tokens.empty()) {
+			throw JsonException("JSON Patch cannot remove the whole document");
+		}
+		JsonNode& parent = resolveParent(target, tokens);
+		if (parent.getType() == JsonNodeType::VALUE_ARRAY) {
+			parent.remove(parseIndex(tokens.back(), parent.size()));
+		} else if (!parent.remove(tokens.back())) {
+			throw JsonException("JSON Patch cannot remove a missing value: ", tokens.back());
+		}
+	}
+
+	static void applyOperation(JsonNode& target, const JsonNode& operation, size_t maxDepth) {
+		const std::string& op = operation.getString("op");
+		const std::vector<std::string> path = parseJsonPointer(operation.getString("path"));
+		if (op == "add" || op == "replace" || op == "test") {
+			const JsonNode* value = operation.find("value");
+			if (value == nullptr) {
+				throw JsonException("JSON Patch operation is missing a value: ", op);
+			}
+			if (op == "test") {
+				if (!resolve(target, path).deepEquals(*value, maxDepth)) {
+					throw JsonException("JSON Patch test failed at: ", operation.getString("path"));
+				}
+				return;
+			}
+			JsonNode copy;
+			value->copyTo(copy, maxDepth);
+			if (op == "replace") {
+				resolve(target, path) = std::move(copy);
+			} else {
+				add(target, path, copy);
+			}
+		} else if (op == "remove") {
+			remove(target, path);
+		} else if (op == "move" || op == "copy") {
+			const std::string& fromPointer = operation.getString("from");
+			const std::vector<std::string> from = parseJsonPointer(fromPointer);
+			JsonNode value;
+			if (op == "copy") {
+				resolve(target, from).copyTo(value, maxDepth);
+			} else {
+				const std::string& pathPointer = operation.getString("path");
+				if (pathPointer == fromPointer) {
+					return;
+				}
+				if (pathPointer.compare(0, fromPointer.size() + 1, fromPointer + "/") == 0) {
+					throw JsonException("JSON Patch cannot move a value into itself: ", fromPointer);
+				}
+				value = std::move(resolve(target, from));
+				remove(target, from);
+			}
+			add(target, path, value);
+		} else {
+			throw JsonException("Unknown JSON Patch operation: ", op);
+		}
+	}
+};
+
+// Applies a patch while copying a document from a parser to a generator, so
+// the document never has to be held in memory.  Subtrees the patch doesn't
+// touch are copied as raw bytes.
+//
+// JSON Patch operations are addressed against the original document rather
+// than applied one after another: array indices refer to the original
+// elements (an add inserts before one), each location can be the target of a
+// single operation, operations can't target locations inside each other, and
+// move and copy aren't supported.  So that a patch never means something
+// different than it would applied in sequence, one that inserts or removes
+// at an index can't be followed by another under the same parent, except an
+// add at "-".  Numeric object keys are treated as indices for this.  The
+// patch must outlive the patcher.
+class JsonStreamingPatcher {
+public:
+	// Prepares an RFC 7396 merge patch
+	static JsonStreamingPatcher fromMergePatch(const JsonNode& patch) {
+		JsonStreamingPatcher patcher;
+		patcher.root.reset(new Edit);
+		buildMerge(*patcher.root, patch);
+		return patcher;
+	}
+
+	// Prepares an RFC 6902 patch, with the restrictions above
+	static JsonStreamingPatcher fromJsonPatch(const JsonNode& operations) {
+		if (operations.getType() != JsonNodeType::VALUE_ARRAY) {
+			throw JsonException("A JSON Patch must be an array of operations");
+		}
+		JsonStreamingPatcher patcher;
+		patcher.root.reset(new Edit);
+		for (size_t i = 0; i < operations.size(); ++i) {
+			patcher.addOperation(operations[i]);
+		}
+		return patcher;
+	}
+
+	// Patches every top level value in the stream.  Returns the number of
+	// values written.
+	template <class source, class dest>
+	uint64_t apply(JsonParser<source>& parser, JsonGenerator<dest>& generator, size_t maxDepth = 50) {
+		uint64_t count = 0;
+		if (parser.currentToken() == JsonToken::NOT_AVAILABLE) {
+			parser.nextToken();
+		}
+		while (parser.currentToken() != JsonToken::NOT_AVAILABLE) {
+			transform(parser, generator, root.get(), maxDepth);
+			++count;
+		}
+		return count;
+	}
+
+private:
+	enum class EditKind {
+		// Only leads to other edits
+		NONE,
+		// Sets an object field, inserts into an array or replaces the root
+		ADD,
+		REPLACE,
+		REMOVE,
+		TEST,
+		// Merges a patch object into whatever is there
+		MERGE
+	};
+
+	struct Edit {
+		EditKind kind = EditKind::NONE;
+		// Whether the location has to exist, as in JSON Patch
+		bool required = false;
+		// Whether an operation has inserted or removed one of the children,
+		// moving the indices of those after it
+		bool shifted = false;
+		const JsonNode* value = nullptr;
+		std::vector<std::pair<std::string, std::unique_ptr<Edit>>> children;
+		std::unordered_map<std::string, size_t> childIndex;
+
+		Edit* find(const std::string& key) const {
+			auto it = childIndex.find(key);
+			return it == childIndex.end() ? nullptr : children[it->second].second.get();
+		}
+
+		Edit& child(const std::string& key) {
+			Edit* existing = find(key);
+			if (existing != nullptr) {
+				return *existing;
+			}
+			childIndex.emplace(key, children.size());
+			children.emplace_back(key, std::unique_ptr<Edit>(new Edit));
+			return *children.back().second;
+		}
+	};
+
+	std::unique_ptr<Edit> root;
+	std::string raw;
+
+	static void buildMerge(Edit& edit, const JsonNode& patch) {
+		edit.value = &patch;
+		if (patch.getType() != JsonNodeType::VALUE_OBJECT) {
+			edit.kind = EditKind::ADD;
+			return;
+		}
+		edit.kind = EditKind::MERGE;
+		for (size_t i = 0; i < patch.size(); ++i) {
+			auto field = patch.getField(i);
+			Edit& child = edit.child(field.first);
+			if (field.second.isNull()) {
+				child.kind = EditKind::REMOVE;
+			} else {
+				buildMerge(child, field.second);
+			}
+		}
+	}
+
+	void addOperation(const JsonNode& operation) {
+		const std::string& op = operation.getString("op");
+		const std::vector<std::string> path = parseJsonPointer(operation.getString("path"));
+		EditKind kind;
+		if (op == "add") {
+			kind = EditKind::ADD;
+		} else if (op == "replace") {
+			kind = EditKind::REPLACE;
+		} else if (op == "remove") {
+			kind = EditKind::REMOVE;
+		} else if (op == "test") {
+			kind = EditKind::TEST;
+		} else {
+			throw JsonException("JSON Patch operation can't be streamed: ", op);
+		}
+		const JsonNode* value = operation.find("value");
+		if (kind != EditKind::REMOVE && value == nullptr) {
+			throw JsonException("JSON Patch operation is missing a value: ", op);
+		}
+		if (path.empty() && kind == EditKind::REMOVE) {
+			throw JsonException("JSON Patch cannot remove the whole document");
+		}
+		Edit* edit = root.get();
+		Edit* parent = nullptr;
+		for (const auto& token : path) {
+			if (edit->kind != EditKind::NONE) {
+				throw JsonException("JSON Patch operations overlap at: ", operation.getString("path"));
+			}
+			if (edit->shifted && isIndex(token)) {
+				throw JsonException("JSON Patch index was shifted by an earlier operation: ", operation.getString("path"));
+			}
+			edit->required = true;
+			parent = edit;
+			edit = &edit->child(token);
+		}
+		if (edit->kind != EditKind::NONE || !edit->children.empty()) {
+			throw JsonException("JSON Patch operations overlap at: ", operation.getString("path"));
+		}
+		if ((kind == EditKind::ADD || kind == EditKind::REMOVE) && parent != nullptr && isIndex(path.back())) {
+			parent->shifted = true;
+		}
+		edit->kind = kind;
+		edit->required = kind != EditKind::ADD;
+		edit->value = value;
+	}
+
+	static bool isIndex(const std::string& token) {
+		return !token.empty() && token.find_first_not_of("0123456789") == std::string::npos;
+	}
+
+	// Writes a merge patch value as it would be merged into nothing
+	template <class dest>
+	static void writeMergeValue(JsonGenerator<dest>& generator, const JsonNode& value, size_t maxDepth) {
+		if (value.getType() != JsonNodeType::VALUE_OBJECT) {
+			value.write(generator, maxDepth);
+			return;
+		}
+		if (maxDepth == 0) {
+			throw JsonException("Max depth exceeded while writing a merge patch");
+		}
+		generator.startObject();
+		for (size_t i = 0; i < value.size(); ++i) {
+			auto field = value.getField(i);
+			if (!field.second.isNull()) {
+				generator.writeFieldName(field.first);
+				writeMergeValue(generator, field.second, maxDepth - 1);
+			}
+		}
+		generator.endObject();
+	}
+
+	// Copies the value at the parser's current token, leaving the parser on
+	// the token after it
+	template <class source, class dest>
+	void copyValue(JsonParser<source>& parser, JsonGenerator<dest>& generator) {
+		JsonToken token = parser.currentToken();
+		if (token == JsonToken::START_OBJECT || token == JsonToken::START_ARRAY) {
+			raw.assign(1, token == JsonToken::START_OBJECT ? '{' : '[');
+			parser.fastSkipChildren(nullptr, &raw);
+			generator.writeRawValue(raw);
+		} else {
+			generator.copyCurrentEvent(parser);
+		}
+		parser.nextToken();
+	}
+
+	template <class source>
+	static void skipValue(JsonParser<source>& parser) {
+		parser.fastSkipChildren();
+		parser.nextToken();
+	}
+
+	// Patches the value at the parser's current token, leaving the parser on
+	// the token after it
+	template <class source, class dest>
+	void transform(JsonParser<source>& parser, JsonGenerator<dest>& generator, const Edit* edit, size_t maxDepth) {
+		// An empty patch leaves any value, scalars included, as it was
+		if (edit == nullptr || (edit->kind == EditKind::NONE && edit->children.empty())) {
+			copyValue(parser, generator);
+			return;
+		}
+		JsonToken token = parser.currentToken();
+		switch (edit->kind) {
+		case EditKind::ADD:
+		case EditKind::REPLACE:
+			skipValue(parser);
+			edit->value->write(generator, maxDepth);
+			return;
+		case EditKind::TEST: {
+			JsonNode node;
+			node.read(parser, maxDepth);
+			if (!node.deepEquals(*edit->value, maxDepth)) {
+				throw JsonException("JSON Patch test failed");
+			}
+			node.write(generator, maxDepth);
+		}
+			return;
+		case EditKind::MERGE:
+			if (token != JsonToken::START_OBJECT) {
+				skipValue(parser);
+				writeMergeValue(generator, *edit->value, maxDepth);
+				return;
+			}
+			break;
+		default:
+			break;
+		}
+		if (maxDepth == 0) {
+			throw JsonException("Max depth exceeded while patching");
+		}
+		if (token == JsonToken::START_OBJECT) {
+			transformObject(parser, generator, *edit, maxDepth);
+		} else if (token == JsonToken::START_ARRAY) {
+			transformArray(parser, generator, *edit, maxDepth);
+		} else {
+			throw JsonException("JSON Patch path descends into a scalar");
+		}
+	}
+
+	template <class source, class dest>
+	void transformObject(JsonParser<source>& parser, JsonGenerator<dest>& generator, const Edit& edit, size_t maxDepth) {
+		std::vector<bool> seen(edit.children.size(), false);
+		generator.startObject();
+		parser.nextToken();
+		while (parser.currentToken() == JsonToken::FIELD_NAME) {
+			auto it = edit.childIndex.find(parser.getCurrentName());
+			if (it == edit.childIndex.end()) {
+				generator.writeFieldName(parser.getCurrentName());
+				parser.nextToken();
+				copyValue(parser, generator);
+				continue;
+			}
+			seen[it->second] = true;
+			const Edit& child = *edit.children[it->second].second;
+			if (child.kind == EditKind::REMOVE || child.kind == EditKind::ADD || child.kind == EditKind::REPLACE) {
+				parser.skipNextValue();
+				parser.nextToken();
+				if (child.kind != EditKind::REMOVE) {
+					generator.writeFieldName(edit.children[it->second].first);
+					child.value->write(generator, maxDepth - 1);
+				}
+				continue;
+			}
+			generator.writeFieldName(parser.getCurrentName());
+			parser.nextToken();
+			transform(parser, generator, &child, maxDepth - 1);
+		}
+		if (parser.currentToken() != JsonToken::END_OBJECT) {
+			throw JsonException("Unexpected end of stream while patching");
+		}
+		for (size_t i = 0; i < edit.children.size(); ++i) {
+			const Edit& child = *edit.children[i].second;
+			if (seen[i]) {
+				continue;
+			}
+			if (child.required) {
+				throw JsonException("JSON Patch refers to a missing field: ", edit.children[i].first);
+			}
+			if (child.kind == EditKind::ADD) {
+				generator.writeFieldName(edit.children[i].first);
+				child.value->write(generator, maxDepth - 1);
+			} else if (child.kind == EditKind::MERGE) {
+				generator.writeFieldName(edit.children[i].first);
+				writeMergeValue(generator, *child.value, maxDepth - 1);
+			}
+		}
+		generator.endObject();
+		parser.nextToken();
+	}
+
+	template <class source, class dest>
+	void transformArray(JsonParser<source>& parser, JsonGenerator<dest>& generator, const Edit& edit, size_t maxDepth) {
+		// Indices, with "-" as the end of the array
+		static const size_t end = static_cast<size_t>(-1);
+		std::map<size_t, const Edit*> children;
+		for (const auto& child : edit.children) {
+			size_t index = end;
+			if (child.first != "-") {
+				if (child.first.empty() || child.first.size() > 18 || (child.first.size() > 1 && child.first[0] == '0')
+					|| child.first.find_first_not_of("0123456789") != std::string::npos) {
+					throw JsonException("Invalid array index in JSON Pointer: ", child.first);
+				}
+				index = std::stoull(child.first);
+			} else if (child.second->kind != EditKind::ADD) {
+				throw JsonException("JSON Patch can only add at the end of an array");
+			}
+			children.emplace(index, child.second.get());
+		}
+		generator.startArray();
+		parser.nextToken();
+		size_t index = 0;
+		auto next = children.begin();
+		while (parser.currentToken() != JsonToken::END_ARRAY) {
+			if (parser.currentToken() == JsonToken::NOT_AVAILABLE) {
+				throw JsonException("Unexpected end of stream while patching");
+			}
+			const Edit* child = nullptr;
+			if (next != children.end() && next->first == index) {
+				child = next->second;
+				++next;
+			}
+			if (child == nullptr) {
+				copyValue(parser, generator);
+			} else if (child->kind == EditKind::ADD) {
+				// Inserted before the original element
+				child->value->write(generator, maxDepth - 1);
+				copyValue(parser, generator);
+			} else if (child->kind == EditKind::REMOVE) {
+				skipValue(parser);
+			} else {
+				transform(parser, generator, child, maxDepth - 1);
+			}
+			++index;
+		}
+		for (; next != children.end(); ++next) {
+			if ((next->first != index && next->first != end) || next->second->kind != EditKind::ADD) {
+				throw JsonException("JSON Patch array index out of range");
+			}
+			next->second->value->write(generator, maxDepth - 1);
+		}
+		generator.endArray();
+		parser.nextToken();
+	}
+};
+
+inline JsonNode diff(const JsonNode& from, const JsonNode& to, size_t maxDepth = 50) {
+	return JsonPatch::diff(from, to, maxDepth);
+}
+
+inline void applyPatch(JsonNode& target, const JsonNode& patch, size_t maxDepth = 50) {
+	JsonPatch::apply(target, patch, maxDepth);
+}
+}
+
+#endif
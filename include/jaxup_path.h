@@ -0,0 +1,220 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#ifndef JAXUP_PATH_H
+#define JAXUP_PATH_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "jaxup_common.h"
+
+namespace jaxup {
+
+// One step of the location of a value within a document: a field name or an
+// array index.
+struct JsonPathElement {
+	bool isIndex = false;
+	size_t index = 0;
+	std::string name;
+};
+
+enum class JsonPathSegmentType {
+	FIELD,
+	INDEX,
+	// * or [*]: any field or array element
+	WILDCARD,
+	// ..: zero or more levels of anything
+	DESCENDANT
+};
+
+struct JsonPathSegment {
+	JsonPathSegmentType type;
+	size_t index = 0;
+	std::string name;
+
+	bool matches(const JsonPathElement& element) const {
+		switch (type) {
+		case JsonPathSegmentType::FIELD:
+			return !element.isIndex && element.name == name;
+		case JsonPathSegmentType::INDEX:
+			return element.isIndex && element.index == index;
+		default:
+			return true;
+		}
+	}
+};
+
+// A pattern over value locations, written like .store.books[*].title, where:
+//   .name or ["name"]  a field
+//   [n]                an array element
+//   * or [*]           any field or element
+//   ..                 any number of levels, as in ..password
+// The leading dot is optional and an empty pattern matches the root.
+class JsonPath {
+public:
+	static const int FULL_MATCH = 1;
+	static const int PREFIX_MATCH = 2;
+
+	JsonPath() = default;
+
+	explicit JsonPath(const std::string& pattern) {
+		parse(pattern);
+	}
+
+	const std::vector<JsonPathSegment>& getSegments() const {
+		return segments;
+	}
+
+	bool empty() const {
+		return segments.empty();
+	}
+
+	// Compares the pattern against a location.  The result has FULL_MATCH set
+	// when the location matches the pattern, and PREFIX_MATCH set when values
+	// below the location could still match.
+	int match(const std::vector<JsonPathElement>& path) const {
+		return matchFrom(0, path, 0);
+	}
+
+	bool matches(const std::vector<JsonPathElement>& path) const {
+		return (match(path) & FULL_MATCH) != 0;
+	}
+
+private:
+	std::vector<JsonPathSegment> segments;
+
+	int matchFrom(size_t pi, const std::vector<JsonPathElement>& path, size_t si) const {
+		if (si == path.size()) {
+			size_t k = pi;
+			while (k < segments.size() && segments[k].type == JsonPathSegmentType::DESCENDANT) {
+				++k;
+			}
+			int result = k == segments.size() ? FULL_MATCH : 0;
+			if (pi < segments.size()) {
+				result |= PREFIX_MATCH;
+			}
+			return result;
+		}
+		if (pi == segments.size()) {
+			return 0;
+		}
+		const JsonPathSegment& segment = segments[pi];
+		if (segment.type == JsonPathSegmentType::DESCENDANT) {
+			return matchFrom(pi + 1, path, si) | matchFrom(pi, path, si + 1);
+		}
+		if (segment.matches(path[si])) {
+			return matchFrom(pi + 1, path, si + 1);
+		}
+		return 0;
+	}
+
+	static bool isNameCharacter(char c) {
+		return c != '.' && c != '[' && c != ']' && c != ' ' && c != '\t' && c != '|' && c != ',' && c != ')' && c != '}' && c != '=' && c != '!' && c != '<' && c != '>' && c != '"' && c != ':';
+	}
+
+	void add(JsonPathSegmentType type, const std::string& name = std::string(), size_t index = 0) {
+		JsonPathSegment segment;
+		segment.type = type;
+		segment.name = name;
+		segment.index = index;
+		segments.push_back(segment);
+	}
+
+	static std::string parseQuoted(const std::string& pattern, size_t& i) {
+		std::string name;
+		++i;
+		while (i < pattern.size() && pattern[i] != '"') {
+			if (pattern[i] == '\\' && i + 1 < pattern.size()) {
+				++i;
+			}
+			name.push_back(pattern[i++]);
+		}
+		if (i >= pattern.size()) {
+			throw JsonException("Unterminated quoted name in path: ", pattern);
+		}
+		++i;
+		return name;
+	}
+
+	void parse(const std::string& pattern) {
+		size_t i = 0;
+		bool expectName = true;
+		while (i < pattern.size()) {
+			char c = pattern[i];
+			if (c == '.') {
+				if (i + 1 < pattern.size() && pattern[i + 1] == '.') {
+					add(JsonPathSegmentType::DESCENDANT);
+					i += 2;
+				} else {
+					++i;
+				}
+				expectName = true;
+			} else if (c == '[') {
+				parseBracket(pattern, i);
+				expectName = false;
+			} else if (expectName && c == '*') {
+				add(JsonPathSegmentType::WILDCARD);
+				++i;
+				expectName = false;
+			} else if (expectName && isNameCharacter(c)) {
+				size_t start = i;
+				while (i < pattern.size() && isNameCharacter(pattern[i])) {
+					++i;
+				}
+				add(JsonPathSegmentType::FIELD, pattern.substr(start, i - start));
+				expectName = false;
+			} else {
+				throw JsonException("Unexpected character in path: ", pattern);
+			}
+		}
+	}
+
+	void parseBracket(const std::string& pattern, size_t& i) {
+		++i;
+		if (i < pattern.size() && pattern[i] == '"') {
+			add(JsonPathSegmentType::FIELD, parseQuoted(pattern, i));
+		} else if (i < pattern.size() && pattern[i] == '*') {
+			add(JsonPathSegmentType::WILDCARD);
+			++i;
+		} else {
+			size_t start = i;
+			while (i < pattern.size() && pattern[i] >= '0' && pattern[i] <= '9') {
+				++i;
+			}
+			if (i == start) {
+				throw JsonException("Expected an index in path: ", pattern);
+			}
+			add(JsonPathSegmentType::INDEX, std::string(), std::strtoull(pattern.c_str() + start, nullptr, 10));
+		}
+		if (i >= pattern.size() || pattern[i] != ']') {
+			throw JsonException("Expected ] in path: ", pattern);
+		}
+		++i;
+	}
+};
+}
+
+#endif
@@ -0,0 +1,484 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#ifndef JAXUP_PIPELINE_H
+#define JAXUP_PIPELINE_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "jaxup_common.h"
+#include "jaxup_generator.h"
+#include "jaxup_parser.h"
+
+namespace jaxup {
+
+// Bounded single producer/single consumer ring buffer.  Capacity is rounded up
+// to a power of two.  push and pop spin briefly and then block, so a stalled
+// stage doesn't keep a core busy; the lock is only taken once a side sleeps.
+template <class T>
+class JsonSpscQueue {
+public:
+	explicit JsonSpscQueue(size_t minCapacity) {
+		size_t capacity = 2;
+		while (capacity < minCapacity) {
+			capacity <<= 1;
+		}
+		slots.resize(capacity);
+		mask = capacity - 1;
+	}
+
+	JsonSpscQueue(const JsonSpscQueue&) = delete;
+	JsonSpscQueue& operator=(const JsonSpscQueue&) = delete;
+
+	bool tryPush(T&& item) {
+		const size_t t = tail.load(std::memory_order_relaxed);
+		if (t - head.load(std::memory_order_acquire) > mask) {
+			return false;
+		}
+		slots[t & mask] = std::move(item);
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool tryPop(T& item) {
+		const size_t h = head.load(std::memory_order_relaxed);
+		if (h == tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+		item = std::move(slots[h & mask]);
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Waits for room.  Returns false if cancelled first.
+	bool push(T&& item, const std::atomic<bool>& cancelled) {
+		return wait([&]() {
+			return tryPush(std::move(item));
+		}, cancelled);
+	}
+
+	// Waits for an item.  Returns false if cancelled first.
+	bool pop(T& item, const std::atomic<bool>& cancelled) {
+		return wait([&]() {
+			return tryPop(item);
+		}, cancelled);
+	}
+
+	// Wakes a blocked side after the cancellation flag has been set
+	void wakeAll() {
+		std::lock_guard<std::mutex> lock(mutex);
+		wake.notify_all();
+	}
+
+private:
+	static const unsigned int spinLimit = 64;
+
+	std::vector<T> slots;
+	size_t mask;
+	alignas(64) std::atomic<size_t> head{0};
+	alignas(64) std::atomic<size_t> tail{0};
+	alignas(64) std::atomic<unsigned int> sleepers{0};
+	std::mutex mutex;
+	std::condition_variable wake;
+
+	template <class Attempt>
+	bool wait(Attempt attempt, const std::atomic<bool>& cancelled) {
+		for (unsigned int i = 0; i < spinLimit; ++i) {
+			if (attempt()) {
+				notify();
+				return true;
+			}
+			if (cancelled.load(std::memory_order_relaxed)) {
+				return false;
+			}
+			std::this_thread::yield();
+		}
+		bool done;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			sleepers.fetch_add(1, std::memory_order_relaxed);
+			// Pairs with the fence in notify, so either this attempt sees the
+			// other side's update or the other side sees a sleeper
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			while (!(done = attempt()) && !cancelled.load(std::memory_order_relaxed)) {
+				wake.wait(lock);
+			}
+			sleepers.fetch_sub(1, std::memory_order_relaxed);
+		}
+		if (done) {
+			notify();
+		}
+		return done;
+	}
+
+	void notify() {
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (sleepers.load(std::memory_order_relaxed) != 0) {
+			std::lock_guard<std::mutex> lock(mutex);
+			wake.notify_all();
+		}
+	}
+};
+
+// A run of parsed tokens with the text of strings and field names packed into a
+// single buffer.  Repeated field names within a batch share their storage.
+class JsonTokenBatch {
+public:
+	struct Token {
+		JsonToken type;
+		uint32_t textLength;
+		union {
+			int64_t integer;
+			double number;
+			uint64_t textOffset;
+		};
+	};
+
+	JsonTokenBatch() : internTable(internTableSize, 0) {
+	}
+
+	size_t size() const {
+		return tokens.size();
+	}
+
+	bool empty() const {
+		return tokens.empty();
+	}
+
+	const Token& operator[](size_t n) const {
+		return tokens[n];
+	}
+
+	const char* getTextData(const Token& t) const {
+		return text.data() + t.textOffset;
+	}
+
+	std::string getText(const Token& t) const {
+		return std::string(getTextData(t), t.textLength);
+	}
+
+	// Set when the batch holds the final tokens of the stream
+	bool isLast() const {
+		return last;
+	}
+
+	void setLast(bool newLast) {
+		last = newLast;
+	}
+
+	void clear() {
+		tokens.clear();
+		text.clear();
+		if (internCount > 0) {
+			std::fill(internTable.begin(), internTable.end(), 0);
+			internCount = 0;
+		}
+		last = false;
+	}
+
+	void swap(JsonTokenBatch& rhs) {
+		tokens.swap(rhs.tokens);
+		text.swap(rhs.text);
+		internTable.swap(rhs.internTable);
+		std::swap(internCount, rhs.internCount);
+		std::swap(last, rhs.last);
+	}
+
+	void append(JsonToken type) {
+		Token t;
+		t.type = type;
+		t.textLength = 0;
+		t.integer = 0;
+		tokens.push_back(t);
+	}
+
+	void appendInteger(int64_t value) {
+		Token t;
+		t.type = JsonToken::VALUE_NUMBER_INT;
+		t.textLength = 0;
+		t.integer = value;
+		tokens.push_back(t);
+	}
+
+	void appendDouble(double value) {
+		Token t;
+		t.type = JsonToken::VALUE_NUMBER_FLOAT;
+		t.textLength = 0;
+		t.number = value;
+		tokens.push_back(t);
+	}
+
+	void appendString(const char* data, size_t length) {
+		Token t;
+		t.type = JsonToken::VALUE_STRING;
+		t.textLength = checkLength(length);
+		t.textOffset = text.size();
+		text.append(data, length);
+		tokens.push_back(t);
+	}
+
+	void appendFieldName(const char* data, size_t length) {
+		Token t;
+		t.type = JsonToken::FIELD_NAME;
+		t.textLength = checkLength(length);
+		t.textOffset = intern(data, length);
+		tokens.push_back(t);
+	}
+
+	void appendToken(const JsonTokenBatch& other, const Token& t) {
+		switch (t.type) {
+		case JsonToken::VALUE_STRING:
+			appendString(other.getTextData(t), t.textLength);
+			break;
+		case JsonToken::FIELD_NAME:
+			appendFieldName(other.getTextData(t), t.textLength);
+			break;
+		default:
+			tokens.push_back(t);
+		}
+	}
+
+	// Pulls up to maxTokens tokens out of the parser.  Returns false once the
+	// end of the stream has been reached.
+	template <class source>
+	bool fill(JsonParser<source>& parser, size_t maxTokens) {
+		for (size_t i = 0; i < maxTokens; ++i) {
+			JsonToken type = parser.nextToken();
+			switch (type) {
+			case JsonToken::NOT_AVAILABLE:
+				last = true;
+				return false;
+			case JsonToken::FIELD_NAME:
+				appendFieldName(parser.getCurrentName().data(), parser.getCurrentName().length());
+				break;
+			case JsonToken::VALUE_STRING:
+				appendString(parser.getText().data(), parser.getText().length());
+				break;
+			case JsonToken::VALUE_NUMBER_INT:
+				appendInteger(parser.getIntegerValue());
+				break;
+			case JsonToken::VALUE_NUMBER_FLOAT:
+				appendDouble(parser.getDoubleValue());
+				break;
+			default:
+				append(type);
+			}
+		}
+		return true;
+	}
+
+	template <class dest>
+	void write(JsonGenerator<dest>& generator) const {
+		for (const auto& t : tokens) {
+			switch (t.type) {
+			case JsonToken::START_OBJECT:
+				generator.startObject();
+				break;
+			case JsonToken::END_OBJECT:
+				generator.endObject();
+				break;
+			case JsonToken::START_ARRAY:
+				generator.startArray();
+				break;
+			case JsonToken::END_ARRAY:
+				generator.endArray();
+				break;
+			case JsonToken::FIELD_NAME:
+				generator.writeFieldName(getTextData(t), t.textLength);
+				break;
+			case JsonToken::VALUE_STRING:
+				generator.write(getTextData(t), t.textLength);
+				break;
+			case JsonToken::VALUE_NUMBER_INT:
+				generator.write(t.integer);
+				break;
+			case JsonToken::VALUE_NUMBER_FLOAT:
+				generator.write(t.number);
+				break;
+			case JsonToken::VALUE_TRUE:
+				generator.write(true);
+				break;
+			case JsonToken::VALUE_FALSE:
+				generator.write(false);
+				break;
+			case JsonToken::VALUE_NULL:
+				generator.write(nullptr);
+				break;
+			case JsonToken::NOT_AVAILABLE:
+				break;
+			}
+		}
+	}
+
+private:
+	static const size_t internTableSize = 512;
+	static const size_t maxInterned = internTableSize / 2;
+
+	std::vector<Token> tokens;
+	std::string text;
+	// Packed (offset << 32 | length) + 1 of interned names, zero when empty
+	std::vector<uint64_t> internTable;
+	size_t internCount = 0;
+	bool last = false;
+
+	static uint32_t checkLength(size_t length) {
+		if (length > UINT32_MAX) {
+			throw JsonException("String is too long to be batched");
+		}
+		return static_cast<uint32_t>(length);
+	}
+
+	uint64_t intern(const char* data, size_t length) {
+		if (length > 64 || text.size() > UINT32_MAX) {
+			uint64_t offset = text.size();
+			text.append(data, length);
+			return offset;
+		}
+		// FNV-1a
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < length; ++i) {
+			hash = (hash ^ static_cast<unsigned char>(data[i])) * 16777619u;
+		}
+		size_t slot = hash & (internTableSize - 1);
+		for (;;) {
+			uint64_t entry = internTable[slot];
+			if (entry == 0) {
+				break;
+			}
+			uint64_t offset = (entry - 1) >> 32;
+			if (((entry - 1) & 0xFFFFFFFFu) == length && std::memcmp(text.data() + offset, data, length) == 0) {
+				return offset;
+			}
+			slot = (slot + 1) & (internTableSize - 1);
+		}
+		uint64_t offset = text.size();
+		text.append(data, length);
+		if (internCount < maxInterned) {
+			internTable[slot] = ((offset << 32) | length) + 1;
+			++internCount;
+		}
+		return offset;
+	}
+};
+
+// Runs parsing, a user supplied transformation and generation on three threads
+// connected by single producer/single consumer queues.  Batches are recycled from the generator back
+// to the parser, so a slow stage stalls the ones ahead of it rather than
+// letting memory grow.  The transformation may rewrite each batch as it sees
+// fit, as long as the overall token sequence stays well formed.  Returns the
+// number of tokens parsed.
+template <class source, class dest>
+size_t runJsonPipeline(JsonParser<source>& parser, JsonGenerator<dest>& generator,
+	std::function<void(JsonTokenBatch&)> transform, size_t batchSize = 4096, size_t numBatches = 16) {
+	if (numBatches < 2) {
+		numBatches = 2;
+	}
+	typedef std::unique_ptr<JsonTokenBatch> BatchPtr;
+	JsonSpscQueue<BatchPtr> parsed(numBatches);
+	JsonSpscQueue<BatchPtr> transformed(numBatches);
+	JsonSpscQueue<BatchPtr> recycled(numBatches);
+	for (size_t i = 0; i < numBatches; ++i) {
+		BatchPtr batch(new JsonTokenBatch);
+		recycled.tryPush(std::move(batch));
+	}
+
+	std::atomic<bool> failed(false);
+	std::exception_ptr errors[3];
+	size_t numTokens = 0;
+
+	auto fail = [&](size_t stage) {
+		errors[stage] = std::current_exception();
+		failed = true;
+		parsed.wakeAll();
+		transformed.wakeAll();
+		recycled.wakeAll();
+	};
+
+	std::thread parseThread([&]() {
+		try {
+			BatchPtr batch;
+			bool more = true;
+			while (more && recycled.pop(batch, failed)) {
+				batch->clear();
+				more = batch->fill(parser, batchSize);
+				numTokens += batch->size();
+				parsed.push(std::move(batch), failed);
+			}
+		} catch (...) {
+			fail(0);
+		}
+	});
+
+	std::thread transformThread([&]() {
+		try {
+			BatchPtr batch;
+			bool more = true;
+			while (more && parsed.pop(batch, failed)) {
+				more = !batch->isLast();
+				if (transform) {
+					transform(*batch);
+					batch->setLast(!more);
+				}
+				transformed.push(std::move(batch), failed);
+			}
+		} catch (...) {
+			fail(1);
+		}
+	});
+
+	try {
+		BatchPtr batch;
+		bool more = true;
+		while (more && transformed.pop(batch, failed)) {
+			more = !batch->isLast();
+			batch->write(generator);
+			recycled.push(std::move(batch), failed);
+		}
+	} catch (...) {
+		fail(2);
+	}
+
+	parseThread.join();
+	transformThread.join();
+	for (auto& error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+	return numTokens;
+}
+}
+
+#endif
@@ -0,0 +1,174 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#ifndef JAXUP_POOL_H
+#define JAXUP_POOL_H
+
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "jaxup_generator.h"
+#include "jaxup_parser.h"
+
+namespace jaxup {
+
+template <class source>
+inline void releasePooled(JsonParser<source>&) {
+}
+
+template <class dest>
+inline void releasePooled(JsonGenerator<dest>& generator) {
+	generator.flush();
+}
+
+// Recycles parsers/generators so that their inline buffers don't go back to the
+// allocator after every document.  Each thread keeps a handful of idle objects
+// for itself and spills anything beyond that into a shared, mutex guarded list.
+template <class T>
+class JsonObjectPool {
+public:
+	static const size_t maxThreadLocal = 4;
+	static const size_t maxGlobal = 64;
+
+	static std::unique_ptr<T> take() {
+		auto& local = getThreadLocal();
+		if (!local.empty()) {
+			std::unique_ptr<T> item = std::move(local.back());
+			local.pop_back();
+			return item;
+		}
+		Global& global = getGlobal();
+		std::lock_guard<std::mutex> lock(global.mutex);
+		if (!global.items.empty()) {
+			std::unique_ptr<T> item = std::move(global.items.back());
+			global.items.pop_back();
+			return item;
+		}
+		return nullptr;
+	}
+
+	static void give(std::unique_ptr<T> item) {
+		auto& local = getThreadLocal();
+		if (local.size() < maxThreadLocal) {
+			local.push_back(std::move(item));
+			return;
+		}
+		Global& global = getGlobal();
+		std::lock_guard<std::mutex> lock(global.mutex);
+		if (global.items.size() < maxGlobal) {
+			global.items.push_back(std::move(item));
+		}
+	}
+
+private:
+	struct Global {
+		std::mutex mutex;
+		std::vector<std::unique_ptr<T>> items;
+	};
+
+	static std::vector<std::unique_ptr<T>>& getThreadLocal() {
+		static thread_local std::vector<std::unique_ptr<T>> items;
+		return items;
+	}
+
+	static Global& getGlobal() {
+		static Global global;
+		return global;
+	}
+};
+
+template <class T>
+class JsonPoolHandle {
+public:
+	JsonPoolHandle() = default;
+	explicit JsonPoolHandle(std::unique_ptr<T> item) : item(std::move(item)) {
+	}
+	JsonPoolHandle(JsonPoolHandle&& rhs) noexcept : item(std::move(rhs.item)) {
+	}
+	JsonPoolHandle& operator=(JsonPoolHandle&& rhs) noexcept {
+		if (this != &rhs) {
+			release();
+			item = std::move(rhs.item);
+		}
+		return *this;
+	}
+	JsonPoolHandle(const JsonPoolHandle&) = delete;
+	JsonPoolHandle& operator=(const JsonPoolHandle&) = delete;
+
+	~JsonPoolHandle() {
+		release();
+	}
+
+	void release() {
+		if (item) {
+			releasePooled(*item);
+			JsonObjectPool<T>::give(std::move(item));
+		}
+	}
+
+	T* get() const {
+		return item.get();
+	}
+
+	T& operator*() const {
+		return *item;
+	}
+
+	T* operator->() const {
+		return item.get();
+	}
+
+	explicit operator bool() const {
+		return item != nullptr;
+	}
+
+private:
+	std::unique_ptr<T> item;
+};
+
+template <class source>
+inline JsonPoolHandle<JsonParser<source>> acquireJsonParser(source& input) {
+	std::unique_ptr<JsonParser<source>> parser = JsonObjectPool<JsonParser<source>>::take();
+	if (parser) {
+		parser->reset(input);
+	} else {
+		parser.reset(new JsonParser<source>(input));
+	}
+	return JsonPoolHandle<JsonParser<source>>(std::move(parser));
+}
+
+template <class dest>
+inline JsonPoolHandle<JsonGenerator<dest>> acquireJsonGenerator(dest& output, bool prettyPrint) {
+	std::unique_ptr<JsonGenerator<dest>> generator = JsonObjectPool<JsonGenerator<dest>>::take();
+	if (generator) {
+		generator->reset(output, prettyPrint);
+	} else {
+		generator.reset(new JsonGenerator<dest>(output, prettyPrint));
+	}
+	return JsonPoolHandle<JsonGenerator<dest>>(std::move(generator));
+}
+}
+
+#endif
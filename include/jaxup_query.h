@@ -0,0 +1,1110 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+
+#ifndef JAXUP_QUERY_H
+#define JAXUP_QUERY_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "jaxup_common.h"
+#include "jaxup_generator.h"
+#include "jaxup_node.h"
+#include "jaxup_parser.h"
+
+namespace jaxup {
+
+static inline int getJsonNodeTypeRank(const JsonNode& node) {
+	switch (node.getType()) {
+	case JsonNodeType::VALUE_NULL:
+		return 0;
+	case JsonNodeType::VALUE_BOOLEAN:
+		return node.asBoolean() ? 2 : 1;
+	case JsonNodeType::VALUE_NUMBER_INT:
+	case JsonNodeType::VALUE_NUMBER_FLOAT:
+		return 3;
+	case JsonNodeType::VALUE_STRING:
+		return 4;
+	case JsonNodeType::VALUE_ARRAY:
+		return 5;
+	default:
+		return 6;
+	}
+}
+
+static inline std::vector<const std::string*> getSortedKeys(const JsonNode& node) {
+	std::vector<const std::string*> keys;
+	keys.reserve(node.size());
+	for (size_t i = 0; i < node.size(); ++i) {
+		keys.push_back(&node.getField(i).first);
+	}
+	std::sort(keys.begin(), keys.end(), [](const std::string* a, const std::string* b) { return *a < *b; });
+	return keys;
+}
+
+// Orders values the way jq does: null < false < true < numbers < strings <
+// arrays < objects.  Objects are ordered by their sorted keys first, then by
+// the values under those keys.  Returns <0, 0 or >0.
+static inline int compareJsonNodes(const JsonNode& a, const JsonNode& b) {
+	int rankA = getJsonNodeTypeRank(a);
+	int rankB = getJsonNodeTypeRank(b);
+	if (rankA != rankB) {
+		return rankA < rankB ? -1 : 1;
+	}
+	switch (a.getType()) {
+	case JsonNodeType::VALUE_NUMBER_INT:
+	case JsonNodeType::VALUE_NUMBER_FLOAT:
+		if (a.getType() == JsonNodeType::VALUE_NUMBER_INT && b.getType() == JsonNodeType::VALUE_NUMBER_INT) {
+			return a.asInteger() < b.asInteger() ? -1 : (a.asInteger() > b.asInteger() ? 1 : 0);
+		}
+		return a.asDouble() < b.asDouble() ? -1 : (a.asDouble() > b.asDouble() ? 1 : 0);
+	case JsonNodeType::VALUE_STRING:
+		return a.asString().compare(b.asString());
+	case JsonNodeType::VALUE_ARRAY:
+		for (size_t i = 0; i < a.size() && i < b.size(); ++i) {
+			int result = compareJsonNodes(a[i], b[i]);
+			if (result != 0) {
+				return result;
+			}
+		}
+		return a.size() < b.size() ? -1 : (a.size() > b.size() ? 1 : 0);
+	case JsonNodeType::VALUE_OBJECT: {
+		auto keysA = getSortedKeys(a);
+		auto keysB = getSortedKeys(b);
+		for (size_t i = 0; i < keysA.size() && i < keysB.size(); ++i) {
+			int result = keysA[i]->compare(*keysB[i]);
+			if (result != 0) {
+				return result;
+			}
+		}
+		if (keysA.size() != keysB.size()) {
+			return keysA.size() < keysB.size() ? -1 : 1;
+		}
+		for (const std::string* key : keysA) {
+			int result = compareJsonNodes(a[*key], b[*key]);
+			if (result != 0) {
+				return result;
+			}
+		}
+		return 0;
+	}
+	default:
+		return 0;
+	}
+}
+
+// Evaluates a subset of the jq language:
+//   .  ..  .name  ."name"  .[n]  .[m:n]  .[]  a | b  a, b
+//   literals, (a), [a], {name, name: a, "name": a}
+//   ==  !=  <  <=  >  >=  and  or
+//   select(a)  has(a)  length  keys  not  empty
+// Type errors are suppressed as though every step carried jq's ? operator.
+//
+// Leading path steps are applied to the token stream, so values they don't
+// lead to are skipped without being tokenized and JsonNodes are only built
+// for the values they select.  A query made up only of path steps copies its
+// results straight from the parser without building nodes at all.
+class JsonQuery {
+public:
+	using Emit = std::function<void(const JsonNode&)>;
+
+	explicit JsonQuery(const std::string& query) : text(query) {
+		root = parsePipe();
+		skipWhitespace();
+		if (position != text.size()) {
+			fail("Unexpected character");
+		}
+		planStream();
+	}
+
+	// Runs the query over every top level value in the stream and writes the
+	// results as top level values.  Returns the number of results.
+	template <class source, class dest>
+	size_t run(JsonParser<source>& parser, JsonGenerator<dest>& generator, size_t maxDepth = 50) const {
+		size_t count = 0;
+		if (parser.currentToken() == JsonToken::NOT_AVAILABLE) {
+			parser.nextToken();
+		}
+		while (parser.currentToken() != JsonToken::NOT_AVAILABLE) {
+			count += runValue(parser, generator, maxDepth);
+		}
+		return count;
+	}
+
+	// Runs the query over the value at the parser's current token, leaving the
+	// parser on the token after it.  Returns the number of results.
+	template <class source, class dest>
+	size_t runValue(JsonParser<source>& parser, JsonGenerator<dest>& generator, size_t maxDepth = 50) const {
+		size_t count = 0;
+		stream(parser, 0, generator, maxDepth, count);
+		return count;
+	}
+
+	void evaluate(const JsonNode& input, const Emit& emit) const {
+		evaluate(*root, input, emit);
+	}
+
+private:
+	enum class Operation {
+		IDENTITY,
+		RECURSE,
+		FIELD,
+		INDEX,
+		SLICE,
+		ITERATE,
+		LITERAL,
+		PIPE,
+		COMMA,
+		OBJECT,
+		ARRAY,
+		EQUAL,
+		NOT_EQUAL,
+		LESS,
+		LESS_EQUAL,
+		GREATER,
+		GREATER_EQUAL,
+		AND,
+		OR,
+		NOT,
+		SELECT,
+		HAS,
+		LENGTH,
+		KEYS,
+		EMPTY
+	};
+
+	struct Expression {
+		Operation operation = Operation::IDENTITY;
+		std::string name;
+		// Also the start of a slice
+		int64_t index = 0;
+		bool hasEnd = false;
+		int64_t end = 0;
+		JsonNode literal;
+		// Object construction keeps its field names here
+		std::vector<std::string> names;
+		std::vector<std::unique_ptr<Expression>> children;
+	};
+
+	// A path step that can be applied to the token stream
+	struct StreamStep {
+		Operation operation;
+		std::string name;
+		size_t begin = 0;
+		size_t end = SIZE_MAX;
+		// First pipeline stage after this step
+		size_t nextStage = 0;
+	};
+
+	using ExpressionPtr = std::unique_ptr<Expression>;
+
+	std::string text;
+	size_t position = 0;
+	ExpressionPtr root;
+	std::vector<const Expression*> stages;
+	std::vector<StreamStep> steps;
+	size_t remainderStart = 0;
+
+	static const JsonNode& getNullNode() {
+		static const JsonNode nullNode;
+		return nullNode;
+	}
+
+	static bool isTruthy(const JsonNode& node) {
+		return !node.isNull() && !(node.getType() == JsonNodeType::VALUE_BOOLEAN && !node.asBoolean());
+	}
+
+	void planStream() {
+		if (root->operation == Operation::PIPE) {
+			for (const auto& child : root->children) {
+				stages.push_back(child.get());
+			}
+		} else {
+			stages.push_back(root.get());
+		}
+		size_t i = 0;
+		for (; i < stages.size(); ++i) {
+			const Expression& stage = *stages[i];
+			StreamStep step;
+			step.operation = stage.operation;
+			if (stage.operation == Operation::IDENTITY) {
+				continue;
+			} else if (stage.operation == Operation::FIELD) {
+				step.name = stage.name;
+			} else if (stage.operation == Operation::INDEX && stage.index >= 0) {
+				step.begin = static_cast<size_t>(stage.index);
+			} else if (stage.operation == Operation::SLICE && stage.index >= 0 && (!stage.hasEnd || stage.end >= 0)
+				&& i + 1 < stages.size() && stages[i + 1]->operation == Operation::ITERATE) {
+				// .[m:n][] can iterate over the slice without building it
+				step.operation = Operation::ITERATE;
+				step.begin = static_cast<size_t>(stage.index);
+				step.end = stage.hasEnd ? static_cast<size_t>(stage.end) : SIZE_MAX;
+				++i;
+			} else if (stage.operation != Operation::ITERATE) {
+				break;
+			}
+			step.nextStage = i + 1;
+			steps.push_back(step);
+		}
+		remainderStart = i;
+	}
+
+	template <class source>
+	static void skipValue(JsonParser<source>& parser) {
+		parser.fastSkipChildren();
+		parser.nextToken();
+	}
+
+	template <class dest>
+	void emitFrom(size_t stage, const JsonNode& input, JsonGenerator<dest>& generator, size_t maxDepth, size_t& count) const {
+		evaluatePipe(stages, stage, input, [&](const JsonNode& result) {
+			result.write(generator, maxDepth);
+			++count;
+		});
+	}
+
+	template <class source, class dest>
+	void stream(JsonParser<source>& parser, size_t stepIndex, JsonGenerator<dest>& generator, size_t maxDepth, size_t& count) const {
+		if (stepIndex == steps.size()) {
+			if (remainderStart == stages.size()) {
+				generator.copyCurrentStructure(parser);
+				parser.nextToken();
+				++count;
+			} else {
+				JsonNode node;
+				node.read(parser, maxDepth);
+				emitFrom(remainderStart, node, generator, maxDepth, count);
+			}
+			return;
+		}
+		const StreamStep& step = steps[stepIndex];
+		JsonToken token = parser.currentToken();
+		if (token == JsonToken::VALUE_NULL) {
+			parser.nextToken();
+			if (step.operation != Operation::ITERATE) {
+				emitFrom(step.nextStage, getNullNode(), generator, maxDepth, count);
+			}
+			return;
+		}
+		const bool isObject = token == JsonToken::START_OBJECT;
+		const bool isArray = token == JsonToken::START_ARRAY;
+		if ((step.operation == Operation::FIELD && !isObject) || (step.operation == Operation::INDEX && !isArray)
+			|| (step.operation == Operation::ITERATE && !isArray && !(isObject && step.begin == 0 && step.end == SIZE_MAX))) {
+			skipValue(parser);
+			return;
+		}
+		bool found = false;
+		size_t index = 0;
+		token = parser.nextToken();
+		while (token != JsonToken::END_OBJECT && token != JsonToken::END_ARRAY) {
+			if (token == JsonToken::NOT_AVAILABLE) {
+				throw JsonException("Unexpected end of stream while querying");
+			}
+			bool selected;
+			if (isObject) {
+				selected = step.operation == Operation::ITERATE || (!found && parser.getCurrentName() == step.name);
+				parser.nextToken();
+			} else {
+				selected = index >= step.begin && index < (step.operation == Operation::INDEX ? step.begin + 1 : step.end);
+				++index;
+			}
+			if (selected) {
+				found = true;
+				stream(parser, stepIndex + 1, generator, maxDepth, count);
+			} else {
+				skipValue(parser);
+			}
+			token = parser.currentToken();
+		}
+		parser.nextToken();
+		if (!found && step.operation != Operation::ITERATE) {
+			emitFrom(step.nextStage, getNullNode(), generator, maxDepth, count);
+		}
+	}
+
+	void evaluatePipe(const std::vector<const Expression*>& pipe, size_t stage, const JsonNode& input, const Emit& emit) const {
+		if (stage == pipe.size()) {
+			emit(input);
+			return;
+		}
+		evaluate(*pipe[stage], input, [&](const JsonNode& result) {
+			evaluatePipe(pipe, stage + 1, result, emit);
+		});
+	}
+
+	void recurse(const JsonNode& input, const Emit& emit) const {
+		emit(input);
+		if (input.getType() == JsonNodeType::VALUE_OBJECT) {
+			for (size_t i = 0; i < input.size(); ++i) {
+				recurse(input.getField(i).second, emit);
+			}
+		} else if (input.getType() == JsonNodeType::VALUE_ARRAY) {
+			for (size_t i = 0; i < input.size(); ++i) {
+				recurse(input[i], emit);
+			}
+		}
+	}
+
+	static bool resolveIndex(int64_t index, size_t size, size_t& resolved) {
+		if (index < 0) {
+			index += static_cast<int64_t>(size);
+		}
+		if (index < 0 || static_cast<uint64_t>(index) >= size) {
+			return false;
+		}
+		resolved = static_cast<size_t>(index);
+		return true;
+	}
+
+	static size_t clampSliceBound(int64_t bound, size_t size) {
+		if (bound < 0) {
+			bound += static_cast<int64_t>(size);
+		}
+		if (bound < 0) {
+			return 0;
+		}
+		return std::min(static_cast<size_t>(bound), size);
+	}
+
+	void slice(const Expression& e, const JsonNode& input, const Emit& emit) const {
+		JsonNode result;
+		if (input.getType() == JsonNodeType::VALUE_ARRAY) {
+			size_t begin = clampSliceBound(e.index, input.size());
+			size_t end = e.hasEnd ? clampSliceBound(e.end, input.size()) : input.size();
+			result.makeArray();
+			for (size_t i = begin; i < end; ++i) {
+				input[i].copyTo(result.append());
+			}
+		} else if (input.getType() == JsonNodeType::VALUE_STRING) {
+			const std::string& str = input.asString();
+			size_t begin = clampSliceBound(e.index, str.size());
+			size_t end = e.hasEnd ? clampSliceBound(e.end, str.size()) : str.size();
+			result.setString(begin < end ? str.substr(begin, end - begin) : std::string());
+		} else if (!input.isNull()) {
+			return;
+		}
+		emit(result);
+	}
+
+	void construct(const Expression& e, const JsonNode& input, const Emit& emit) const {
+		std::vector<std::vector<JsonNode>> values(e.children.size());
+		size_t combinations = 1;
+		for (size_t i = 0; i < e.children.size(); ++i) {
+			evaluate(*e.children[i], input, [&values, i](const JsonNode& value) {
+				values[i].emplace_back();
+				value.copyTo(values[i].back());
+			});
+			combinations *= values[i].size();
+		}
+		// Every combination of field values makes one object, as in jq
+		std::vector<size_t> choice(e.children.size(), 0);
+		for (size_t n = 0; n < combinations; ++n) {
+			JsonNode result;
+			result.makeObject();
+			for (size_t i = 0; i < e.children.size(); ++i) {
+				values[i][choice[i]].copyTo(result[e.names[i]]);
+			}
+			emit(result);
+			for (size_t i = e.children.size(); i-- > 0;) {
+				if (++choice[i] < values[i].size()) {
+					break;
+				}
+				choice[i] = 0;
+			}
+		}
+	}
+
+	void compare(const Expression& e, const JsonNode& input, const Emit& emit) const {
+		evaluate(*e.children[0], input, [&](const JsonNode& lhs) {
+			evaluate(*e.children[1], input, [&](const JsonNode& rhs) {
+				int order = compareJsonNodes(lhs, rhs);
+				bool result = false;
+				switch (e.operation) {
+				case Operation::EQUAL:
+					result = order == 0;
+					break;
+				case Operation::NOT_EQUAL:
+					result = order != 0;
+					break;
+				case Operation::LESS:
+					result = order < 0;
+					break;
+				case Operation::LESS_EQUAL:
+					result = order <= 0;
+					break;
+				case Operation::GREATER:
+					result = order > 0;
+					break;
+				default:
+					result = order >= 0;
+					break;
+				}
+				JsonNode node;
+				node.setBoolean(result);
+				emit(node);
+			});
+		});
+	}
+
+	void logical(const Expression& e, const JsonNode& input, const Emit& emit) const {
+		const bool isAnd = e.operation == Operation::AND;
+		evaluate(*e.children[0], input, [&](const JsonNode& lhs) {
+			JsonNode node;
+			if (isTruthy(lhs) != isAnd) {
+				node.setBoolean(!isAnd);
+				emit(node);
+				return;
+			}
+			evaluate(*e.children[1], input, [&](const JsonNode& rhs) {
+				node.setBoolean(isTruthy(rhs));
+				emit(node);
+			});
+		});
+	}
+
+	static size_t countCodePoints(const std::string& str) {
+		size_t count = 0;
+		for (char c : str) {
+			if ((static_cast<unsigned char>(c) & 0xC0) != 0x80) {
+				++count;
+			}
+		}
+		return count;
+	}
+
+	void evaluate(const Expression& e, const JsonNode& input, const Emit& emit) const {
+		const JsonNodeType type = input.getType();
+		switch (e.operation) {
+		case Operation::IDENTITY:
+			emit(input);
+			break;
+		case Operation::RECURSE:
+			recurse(input, emit);
+			break;
+		case Operation::FIELD:
+			if (type == JsonNodeType::VALUE_OBJECT || type == JsonNodeType::VALUE_NULL) {
+				emit(input[e.name]);
+			}
+			break;
+		case Operation::INDEX: {
+			size_t index = 0;
+			if (type == JsonNodeType::VALUE_ARRAY && resolveIndex(e.index, input.size(), index)) {
+				emit(input[index]);
+			} else if (type == JsonNodeType::VALUE_ARRAY || type == JsonNodeType::VALUE_NULL) {
+				emit(getNullNode());
+			}
+		} break;
+		case Operation::SLICE:
+			slice(e, input, emit);
+			break;
+		case Operation::ITERATE:
+			if (type == JsonNodeType::VALUE_OBJECT) {
+				for (size_t i = 0; i < input.size(); ++i) {
+					emit(input.getField(i).second);
+				}
+			} else if (type == JsonNodeType::VALUE_ARRAY) {
+				for (size_t i = 0; i < input.size(); ++i) {
+					emit(input[i]);
+				}
+			}
+			break;
+		case Operation::LITERAL:
+			emit(e.literal);
+			break;
+		case Operation::PIPE: {
+			std::vector<const Expression*> pipe;
+			for (const auto& child : e.children) {
+				pipe.push_back(child.get());
+			}
+			evaluatePipe(pipe, 0, input, emit);
+		} break;
+		case Operation::COMMA:
+			for (const auto& child : e.children) {
+				evaluate(*child, input, emit);
+			}
+			break;
+		case Operation::OBJECT:
+			construct(e, input, emit);
+			break;
+		case Operation::ARRAY: {
+			JsonNode result;
+			result.makeArray();
+			if (!e.children.empty()) {
+				evaluate(*e.children[0], input, [&result](const JsonNode& value) {
+					value.copyTo(result.append());
+				});
+			}
+			emit(result);
+		} break;
+		case Operation::EQUAL:
+		case Operation::NOT_EQUAL:
+		case Operation::LESS:
+		case Operation::LESS_EQUAL:
+		case Operation::GREATER:
+		case Operation::GREATER_EQUAL:
+			compare(e, input, emit);
+			break;
+		case Operation::AND:
+		case Operation::OR:
+			logical(e, input, emit);
+			break;
+		case Operation::NOT: {
+			JsonNode node;
+			node.setBoolean(!isTruthy(input));
+			emit(node);
+		} break;
+		case Operation::SELECT:
+			evaluate(*e.children[0], input, [&](const JsonNode& condition) {
+				if (isTruthy(condition)) {
+					emit(input);
+				}
+			});
+			break;
+		case Operation::HAS:
+			evaluate(*e.children[0], input, [&](const JsonNode& key) {
+				JsonNode node;
+				if (type == JsonNodeType::VALUE_OBJECT && key.getType() == JsonNodeType::VALUE_STRING) {
+					bool found = false;
+					for (size_t i = 0; i < input.size() && !found; ++i) {
+						found = input.getField(i).first == key.asString();
+					}
+					node.setBoolean(found);
+				} else if (type == JsonNodeType::VALUE_ARRAY && key.isNumeric()) {
+					node.setBoolean(key.asDouble() >= 0 && key.asDouble() < static_cast<double>(input.size()));
+				} else {
+					return;
+				}
+				emit(node);
+			});
+			break;
+		case Operation::LENGTH: {
+			JsonNode node;
+			if (type == JsonNodeType::VALUE_STRING) {
+				node.setInteger(static_cast<int64_t>(countCodePoints(input.asString())));
+			} else if (type == JsonNodeType::VALUE_NUMBER_INT) {
+				node.setInteger(std::llabs(input.asInteger()));
+			} else if (type == JsonNodeType::VALUE_NUMBER_FLOAT) {
+				node.setDouble(std::abs(input.asDouble()));
+			} else if (type == JsonNodeType::VALUE_BOOLEAN) {
+				return;
+			} else {
+				node.setInteger(static_cast<int64_t>(input.size()));
+			}
+			emit(node);
+		} break;
+		case Operation::KEYS: {
+			JsonNode node;
+			node.makeArray();
+			if (type == JsonNodeType::VALUE_OBJECT) {
+				for (const std::string* key : getSortedKeys(input)) {
+					node.append().setString(*key);
+				}
+			} else if (type == JsonNodeType::VALUE_ARRAY) {
+				for (size_t i = 0; i < input.size(); ++i) {
+					node.append().setInteger(static_cast<int64_t>(i));
+				}
+			} else {
+				return;
+			}
+			emit(node);
+		} break;
+		case Operation::EMPTY:
+			break;
+		}
+	}
+
+	// Query parsing
+
+	[[noreturn]] void fail(const char* message) const {
+		throw JsonException(message, " at position ", std::to_string(position), " in query: ", text);
+	}
+
+	void skipWhitespace() {
+		while (position < text.size() && (text[position] == ' ' || text[position] == '\t' || text[position] == '\r' || text[position] == '\n')) {
+			++position;
+		}
+	}
+
+	bool peek(const char* token) {
+		skipWhitespace();
+		return text.compare(position, std::char_traits<char>::length(token), token) == 0;
+	}
+
+	bool accept(const char* token) {
+		if (!peek(token)) {
+			return false;
+		}
+		position += std::char_traits<char>::length(token);
+		return true;
+	}
+
+	void expect(const char* token) {
+		if (!accept(token)) {
+			fail((std::string("Expected ") + token).c_str());
+		}
+	}
+
+	static bool isIdentifierStart(char c) {
+		return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+	}
+
+	static bool isIdentifierCharacter(char c) {
+		return isIdentifierStart(c) || (c >= '0' && c <= '9');
+	}
+
+	bool peekKeyword(const char* keyword) {
+		size_t length = std::char_traits<char>::length(keyword);
+		return peek(keyword) && (position + length >= text.size() || !isIdentifierCharacter(text[position + length]));
+	}
+
+	bool acceptKeyword(const char* keyword) {
+		if (!peekKeyword(keyword)) {
+			return false;
+		}
+		position += std::char_traits<char>::length(keyword);
+		return true;
+	}
+
+	std::string parseIdentifier() {
+		skipWhitespace();
+		size_t start = position;
+		while (position < text.size() && isIdentifierCharacter(text[position])) {
+			++position;
+		}
+		return text.substr(start, position - start);
+	}
+
+	static void appendUtf8(std::string& out, uint32_t codePoint) {
+		if (codePoint < 0x80) {
+			out.push_back(static_cast<char>(codePoint));
+		} else if (codePoint < 0x800) {
+			out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+			out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+		} else if (codePoint < 0x10000) {
+			out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+			out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+			out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+		} else {
+			out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+			out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+			out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+			out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+		}
+	}
+
+	uint32_t parseHex4() {
+		if (position + 4 > text.size()) {
+			fail("Truncated \\u escape");
+		}
+		uint32_t value = 0;
+		for (int i = 0; i < 4; ++i) {
+			char c = text[position++];
+			value <<= 4;
+			if (c >= '0' && c <= '9') {
+				value |= static_cast<uint32_t>(c - '0');
+			} else if (c >= 'a' && c <= 'f') {
+				value |= static_cast<uint32_t>(c - 'a' + 10);
+			} else if (c >= 'A' && c <= 'F') {
+				value |= static_cast<uint32_t>(c - 'A' + 10);
+			} else {
+				fail("Invalid \\u escape");
+			}
+		}
+		return value;
+	}
+
+	std::string parseStringLiteral() {
+		expect("\"");
+		std::string result;
+		for (;;) {
+			if (position >= text.size()) {
+				fail("Unterminated string");
+			}
+			char c = text[position++];
+			if (c == '"') {
+				return result;
+			}
+			if (c != '\\') {
+				result.push_back(c);
+				continue;
+			}
+			if (position >= text.size()) {
+				fail("Unterminated string");
+			}
+			c = text[position++];
+			switch (c) {
+			case 'b':
+				result.push_back('\b');
+				break;
+			case 'f':
+				result.push_back('\f');
+				break;
+			case 'n':
+				result.push_back('\n');
+				break;
+			case 'r':
+				result.push_back('\r');
+				break;
+			case 't':
+				result.push_back('\t');
+				break;
+			case 'u': {
+				uint32_t codePoint = parseHex4();
+				if (codePoint >= 0xD800 && codePoint < 0xDC00 && text.compare(position, 2, "\\u") == 0) {
+					position += 2;
+					uint32_t low = parseHex4();
+					codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+				}
+				appendUtf8(result, codePoint);
+			} break;
+			default:
+				result.push_back(c);
+				break;
+			}
+		}
+	}
+
+	int64_t parseInteger() {
+		skipWhitespace();
+		size_t start = position;
+		if (position < text.size() && text[position] == '-') {
+			++position;
+		}
+		while (position < text.size() && text[position] >= '0' && text[position] <= '9') {
+			++position;
+		}
+		if (position == start || text[position - 1] == '-') {
+			fail("Expected an integer");
+		}
+		return std::strtoll(text.c_str() + start, nullptr, 10);
+	}
+
+	static ExpressionPtr make(Operation operation) {
+		ExpressionPtr e(new Expression);
+		e->operation = operation;
+		return e;
+	}
+
+	static ExpressionPtr makeBinary(Operation operation, ExpressionPtr lhs, ExpressionPtr rhs) {
+		ExpressionPtr e = make(operation);
+		e->children.push_back(std::move(lhs));
+		e->children.push_back(std::move(rhs));
+		return e;
+	}
+
+	// Pipes are associative, so nested ones are flattened into one list of
+	// stages.  That exposes a query's leading path steps to the streamer.
+	static void appendStage(Expression& pipe, ExpressionPtr stage) {
+		if (stage->operation == Operation::PIPE) {
+			for (auto& child : stage->children) {
+				pipe.children.push_back(std::move(child));
+			}
+		} else {
+			pipe.children.push_back(std::move(stage));
+		}
+	}
+
+	ExpressionPtr parsePipe() {
+		ExpressionPtr first = parseComma();
+		if (!peek("|")) {
+			return first;
+		}
+		ExpressionPtr pipe = make(Operation::PIPE);
+		appendStage(*pipe, std::move(first));
+		while (accept("|")) {
+			appendStage(*pipe, parseComma());
+		}
+		return pipe;
+	}
+
+	ExpressionPtr parseComma() {
+		ExpressionPtr first = parseOr();
+		if (!peek(",")) {
+			return first;
+		}
+		ExpressionPtr comma = make(Operation::COMMA);
+		comma->children.push_back(std::move(first));
+		while (accept(",")) {
+			comma->children.push_back(parseOr());
+		}
+		return comma;
+	}
+
+	ExpressionPtr parseOr() {
+		ExpressionPtr lhs = parseAnd();
+		while (acceptKeyword("or")) {
+			lhs = makeBinary(Operation::OR, std::move(lhs), parseAnd());
+		}
+		return lhs;
+	}
+
+	ExpressionPtr parseAnd() {
+		ExpressionPtr lhs = parseComparison();
+		while (acceptKeyword("and")) {
+			lhs = makeBinary(Operation::AND, std::move(lhs), parseComparison());
+		}
+		return lhs;
+	}
+
+	ExpressionPtr parseComparison() {
+		ExpressionPtr lhs = parsePostfix();
+		static const struct {
+			const char* token;
+			Operation operation;
+		} comparisons[] = {
+			{"==", Operation::EQUAL},
+			{"!=", Operation::NOT_EQUAL},
+			{"<=", Operation::LESS_EQUAL},
+			{">=", Operation::GREATER_EQUAL},
+			{"<", Operation::LESS},
+			{">", Operation::GREATER}
+		};
+		for (const auto& comparison : comparisons) {
+			if (accept(comparison.token)) {
+				return makeBinary(comparison.operation, std::move(lhs), parsePostfix());
+			}
+		}
+		return lhs;
+	}
+
+	// Parses the inside of [...] after a value
+	ExpressionPtr parseBracketStep() {
+		if (accept("]")) {
+			return make(Operation::ITERATE);
+		}
+		ExpressionPtr step;
+		if (peek("\"")) {
+			step = make(Operation::FIELD);
+			step->name = parseStringLiteral();
+		} else if (accept(":")) {
+			step = make(Operation::SLICE);
+			step->hasEnd = true;
+			step->end = parseInteger();
+		} else {
+			int64_t index = parseInteger();
+			if (accept(":")) {
+				step = make(Operation::SLICE);
+				step->index = index;
+				if (!peek("]")) {
+					step->hasEnd = true;
+					step->end = parseInteger();
+				}
+			} else {
+				step = make(Operation::INDEX);
+				step->index = index;
+			}
+		}
+		expect("]");
+		return step;
+	}
+
+	// Parses what may follow a dot: a name, a quoted name or a bracket step.
+	// Returns null if nothing does.
+	ExpressionPtr parseDotStep() {
+		if (position < text.size() && isIdentifierStart(text[position])) {
+			ExpressionPtr step = make(Operation::FIELD);
+			step->name = parseIdentifier();
+			return step;
+		}
+		if (position < text.size() && text[position] == '"') {
+			ExpressionPtr step = make(Operation::FIELD);
+			step->name = parseStringLiteral();
+			return step;
+		}
+		if (position < text.size() && text[position] == '[') {
+			++position;
+			return parseBracketStep();
+		}
+		return nullptr;
+	}
+
+	ExpressionPtr parsePostfix() {
+		ExpressionPtr pipe = make(Operation::PIPE);
+		appendStage(*pipe, parseTerm());
+		for (;;) {
+			if (accept("?")) {
+				continue;
+			}
+			skipWhitespace();
+			if (position + 1 < text.size() && text[position] == '.' && text[position + 1] != '.') {
+				++position;
+				ExpressionPtr step = parseDotStep();
+				if (!step) {
+					fail("Expected a field name");
+				}
+				appendStage(*pipe, std::move(step));
+			} else if (accept("[")) {
+				appendStage(*pipe, parseBracketStep());
+			} else {
+				break;
+			}
+		}
+		if (pipe->children.size() == 1) {
+			return std::move(pipe->children[0]);
+		}
+		return pipe;
+	}
+
+	ExpressionPtr parseFunctionArgument() {
+		expect("(");
+		ExpressionPtr argument = parsePipe();
+		expect(")");
+		return argument;
+	}
+
+	ExpressionPtr parseObject() {
+		ExpressionPtr object = make(Operation::OBJECT);
+		if (accept("}")) {
+			return object;
+		}
+		do {
+			std::string name;
+			if (peek("\"")) {
+				name = parseStringLiteral();
+			} else {
+				name = parseIdentifier();
+				if (name.empty()) {
+					fail("Expected a field name");
+				}
+			}
+			ExpressionPtr value;
+			if (accept(":")) {
+				value = parseOr();
+			} else {
+				value = make(Operation::FIELD);
+				value->name = name;
+			}
+			object->names.push_back(name);
+			object->children.push_back(std::move(value));
+		} while (accept(","));
+		expect("}");
+		return object;
+	}
+
+	ExpressionPtr parseNumber() {
+		size_t start = position;
+		if (text[position] == '-') {
+			++position;
+		}
+		bool isDouble = false;
+		while (position < text.size()) {
+			char c = text[position];
+			if (c == '.' || c == 'e' || c == 'E' || ((c == '+' || c == '-') && (text[position - 1] == 'e' || text[position - 1] == 'E'))) {
+				isDouble = true;
+			} else if (c < '0' || c > '9') {
+				break;
+			}
+			++position;
+		}
+		ExpressionPtr literal = make(Operation::LITERAL);
+		if (isDouble) {
+			literal->literal.setDouble(std::strtod(text.c_str() + start, nullptr));
+		} else {
+			literal->literal.setInteger(std::strtoll(text.c_str() + start, nullptr, 10));
+		}
+		return literal;
+	}
+
+	ExpressionPtr parseTerm() {
+		skipWhitespace();
+		if (position >= text.size()) {
+			fail("Unexpected end of query");
+		}
+		char c = text[position];
+		if (c == '.') {
+			++position;
+			if (position < text.size() && text[position] == '.') {
+				++position;
+				return make(Operation::RECURSE);
+			}
+			ExpressionPtr step = parseDotStep();
+			return step ? std::move(step) : make(Operation::IDENTITY);
+		}
+		if (c == '"') {
+			ExpressionPtr literal = make(Operation::LITERAL);
+			literal->literal.setString(parseStringLiteral());
+			return literal;
+		}
+		if ((c >= '0' && c <= '9') || (c == '-' && position + 1 < text.size() && text[position + 1] >= '0' && text[position + 1] <= '9')) {
+			return parseNumber();
+		}
+		if (accept("(")) {
+			ExpressionPtr inner = parsePipe();
+			expect(")");
+			return inner;
+		}
+		if (accept("{")) {
+			return parseObject();
+		}
+		if (accept("[")) {
+			ExpressionPtr array = make(Operation::ARRAY);
+			if (!accept("]")) {
+				array->children.push_back(parsePipe());
+				expect("]");
+			}
+			return array;
+		}
+		if (peekKeyword("true") || peekKeyword("false")) {
+			ExpressionPtr literal = make(Operation::LITERAL);
+			literal->literal.setBoolean(acceptKeyword("true"));
+			acceptKeyword("false");
+			return literal;
+		}
+		if (acceptKeyword("null")) {
+			return make(Operation::LITERAL);
+		}
+		if (acceptKeyword("select")) {
+			ExpressionPtr function = make(Operation::SELECT);
+			function->children.push_back(parseFunctionArgument());
+			return function;
+		}
+		if (acceptKeyword("has")) {
+			ExpressionPtr function = make(Operation::HAS);
+			function->children.push_back(parseFunctionArgument());
+			return function;
+		}
+		if (acceptKeyword("length")) {
+			return make(Operation::LENGTH);
+		}
+		if (acceptKeyword("keys")) {
+			return make(Operation::KEYS);
+		}
+		if (acceptKeyword("not")) {
+			return make(Operation::NOT);
+		}
+		if (acceptKeyword("empty")) {
+			return make(Operation::EMPTY);
+		}
+		fail("Unexpected token");
+	}
+};
+}
+
+#endif
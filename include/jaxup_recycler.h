@@ -0,0 +1,317 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#ifndef JAXUP_RECYCLER_H
+#define JAXUP_RECYCLER_H
+
+#include <cassert>
+#include <cstddef>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+// Keeps the recycling paths out of the inlined allocation fast path
+#ifdef _MSC_VER
+#define JAXUP_NOINLINE __declspec(noinline)
+#else
+#define JAXUP_NOINLINE __attribute__((noinline))
+#endif
+
+namespace jaxup {
+
+// Nodes only use recyclers when JAXUP_USE_NODE_RECYCLER is defined before
+// the jaxup headers are included, in every translation unit of the program.
+// Otherwise they allocate directly, without checking for a recycler.
+//
+// While a recycler is alive, nodes on its thread hand the container buffers
+// and strings they free to it instead of the allocator, and take them back
+// when they next need one.  Buffers are rounded up to size classes four to
+// a doubling, and strings are kept in power of two classes by capacity.
+// Whatever is still held when the recycler ends is freed, and nodes may
+// outlive it.  Recyclers nest, and the innermost one is used until it ends.
+// One that ends before a recycler nested in it is taken out of the chain, but
+// it has to end on the thread that created it.
+class JsonNodeRecycler {
+public:
+	static const size_t defaultMaxBytes = 64 << 20;
+
+	explicit JsonNodeRecycler(size_t maxBytes = defaultMaxBytes) : maxBytes(maxBytes), previous(active()) {
+		active() = this;
+	}
+	JsonNodeRecycler(const JsonNodeRecycler&) = delete;
+	JsonNodeRecycler& operator=(const JsonNodeRecycler&) = delete;
+	JsonNodeRecycler(JsonNodeRecycler&&) = delete;
+	JsonNodeRecycler& operator=(JsonNodeRecycler&&) = delete;
+
+	~JsonNodeRecycler() {
+		// Usually the innermost, but anything nested in it must not be left
+		// pointing here
+		JsonNodeRecycler** link = &active();
+		while (*link != this && *link != nullptr) {
+			link = &(*link)->previous;
+		}
+		assert(*link == this && "JsonNodeRecycler ended on a different thread than it started");
+		if (*link == this) {
+			*link = previous;
+		}
+		for (auto& list : blocks) {
+			for (void* block : list) {
+				::operator delete(block);
+			}
+		}
+		for (auto& list : strings) {
+			for (std::string* str : list) {
+				delete str;
+			}
+		}
+	}
+
+	// Requests that had to go to the allocator
+	size_t numAllocations() const {
+		return allocations;
+	}
+
+	size_t numRecycled() const {
+		return recycled;
+	}
+
+	size_t getRetainedBytes() const {
+		return retained;
+	}
+
+	// Sizes are rounded up even without a recycler so that a block always
+	// fills its class, wherever it was allocated
+	static inline void* allocate(size_t bytes) {
+		size_t sizeClass = getSizeClass(bytes);
+		JsonNodeRecycler* scope = active();
+		if (scope != nullptr) {
+			return scope->takeBlock(sizeClass);
+		}
+		return ::operator new(getClassSize(sizeClass));
+	}
+
+	static inline void deallocate(void* block, size_t bytes) noexcept {
+		JsonNodeRecycler* scope = active();
+		if (scope != nullptr) {
+			scope->giveBlock(block, getSizeClass(bytes));
+		} else {
+			::operator delete(block);
+		}
+	}
+
+	static inline std::string* acquireString(const char* data, size_t length) {
+		JsonNodeRecycler* scope = active();
+		if (scope != nullptr) {
+			return scope->takeString(data, length);
+		}
+		return new std::string(data, length);
+	}
+
+	static inline void releaseString(std::string* str) noexcept {
+		JsonNodeRecycler* scope = active();
+		if (scope != nullptr) {
+			scope->giveString(str);
+		} else {
+			delete str;
+		}
+	}
+
+private:
+	static const size_t numClasses = 240;
+	static const size_t numStringClasses = 64;
+
+	std::vector<void*> blocks[numClasses];
+	std::vector<std::string*> strings[numStringClasses];
+	size_t maxBytes;
+	size_t retained = 0;
+	size_t allocations = 0;
+	size_t recycled = 0;
+	JsonNodeRecycler* previous;
+
+	JAXUP_NOINLINE void* takeBlock(size_t sizeClass) {
+		auto& list = blocks[sizeClass];
+		if (!list.empty()) {
+			void* block = list.back();
+			list.pop_back();
+			retained -= getClassSize(sizeClass);
+			++recycled;
+			return block;
+		}
+		++allocations;
+		return ::operator new(getClassSize(sizeClass));
+	}
+
+	JAXUP_NOINLINE void giveBlock(void* block, size_t sizeClass) noexcept {
+		if (retained + getClassSize(sizeClass) > maxBytes) {
+			::operator delete(block);
+			return;
+		}
+		// Nodes free memory in destructors and noexcept moves, so this mustn't
+		// throw
+		try {
+			blocks[sizeClass].push_back(block);
+		} catch (const std::bad_alloc&) {
+			::operator delete(block);
+			return;
+		}
+		retained += getClassSize(sizeClass);
+	}
+
+	JAXUP_NOINLINE std::string* takeString(const char* data, size_t length) {
+		// Every string in the class above is long enough, but only some in
+		// this one
+		size_t sizeClass = ceilLog2(length > minCapacity() ? length : minCapacity());
+		for (size_t c = sizeClass; c < sizeClass + 2 && c < numStringClasses; ++c) {
+			auto& list = strings[c];
+			if (!list.empty() && list.back()->capacity() >= length) {
+				std::string* str = list.back();
+				list.pop_back();
+				retained -= str->capacity() + sizeof(std::string);
+				str->assign(data, length);
+				++recycled;
+				return str;
+			}
+		}
+		++allocations;
+		return new std::string(data, length);
+	}
+
+	JAXUP_NOINLINE void giveString(std::string* str) noexcept {
+		size_t bytes = str->capacity() + sizeof(std::string);
+		if (retained + bytes > maxBytes) {
+			delete str;
+			return;
+		}
+		try {
+			strings[ceilLog2(str->capacity())].push_back(str);
+		} catch (const std::bad_alloc&) {
+			delete str;
+			return;
+		}
+		retained += bytes;
+	}
+
+	static JsonNodeRecycler*& active() {
+		static thread_local JsonNodeRecycler* scope = nullptr;
+		return scope;
+	}
+
+	static size_t minCapacity() {
+		static const size_t capacity = std::string().capacity();
+		return capacity;
+	}
+
+	static inline size_t floorLog2(size_t n) {
+#ifdef _MSC_VER
+		unsigned long log;
+		return _BitScanReverse64(&log, n) ? log : 0;
+#else
+		return n == 0 ? 0 : 63 - __builtin_clzll(n);
+#endif
+	}
+
+	static size_t ceilLog2(size_t n) {
+		size_t log = floorLog2(n);
+		return (static_cast<size_t>(1) << log) < n ? log + 1 : log;
+	}
+
+	// Classes step by 16 bytes up to 64, then by a quarter of each power of
+	// two, which fits both node arrays and object fields exactly
+	static size_t getSizeClass(size_t bytes) {
+		if (bytes <= 64) {
+			return bytes == 0 ? 0 : (bytes - 1) / 16;
+		}
+		size_t log = floorLog2(bytes - 1);
+		size_t step = static_cast<size_t>(1) << (log - 2);
+		return 4 + (log - 6) * 4 + (bytes - 1 - (static_cast<size_t>(1) << log)) / step;
+	}
+
+	static size_t getClassSize(size_t sizeClass) {
+		if (sizeClass < 4) {
+			return (sizeClass + 1) * 16;
+		}
+		size_t log = 6 + (sizeClass - 4) / 4;
+		return (static_cast<size_t>(1) << log) + ((sizeClass - 4) % 4 + 1) * (static_cast<size_t>(1) << (log - 2));
+	}
+};
+
+// Routes container buffers through the thread's JsonNodeRecycler, if any
+template <typename T>
+struct JsonRecyclingAllocator {
+	using value_type = T;
+
+	JsonRecyclingAllocator() = default;
+	template <typename U>
+	JsonRecyclingAllocator(const JsonRecyclingAllocator<U>&) {
+	}
+
+	T* allocate(size_t n) {
+		return static_cast<T*>(JsonNodeRecycler::allocate(n * sizeof(T)));
+	}
+
+	void deallocate(T* p, size_t n) {
+		JsonNodeRecycler::deallocate(p, n * sizeof(T));
+	}
+};
+
+template <typename T, typename U>
+inline bool operator == (const JsonRecyclingAllocator<T>&, const JsonRecyclingAllocator<U>&) {
+	return true;
+}
+
+template <typename T, typename U>
+inline bool operator != (const JsonRecyclingAllocator<T>&, const JsonRecyclingAllocator<U>&) {
+	return false;
+}
+
+#ifdef JAXUP_USE_NODE_RECYCLER
+template <typename T>
+using JsonNodeAllocator = JsonRecyclingAllocator<T>;
+
+inline std::string* newNodeString(const char* data, size_t length) {
+	return JsonNodeRecycler::acquireString(data, length);
+}
+
+inline void deleteNodeString(std::string* str) noexcept {
+	JsonNodeRecycler::releaseString(str);
+}
+#else
+template <typename T>
+using JsonNodeAllocator = std::allocator<T>;
+
+inline std::string* newNodeString(const char* data, size_t length) {
+	return new std::string(data, length);
+}
+
+inline void deleteNodeString(std::string* str) noexcept {
+	delete str;
+}
+#endif
+
+}
+
+#endif
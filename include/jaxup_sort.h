@@ -0,0 +1,399 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+
+#ifndef JAXUP_SORT_H
+#define JAXUP_SORT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "jaxup_common.h"
+#include "jaxup_generator.h"
+#include "jaxup_ndjson.h"
+#include "jaxup_node.h"
+#include "jaxup_parser.h"
+#include "jaxup_path.h"
+#include "jaxup_query.h"
+#include "jaxup_thread_pool.h"
+
+namespace jaxup {
+
+// Sorts newline delimited records by one or more key paths in bounded memory.
+// Blocks of input are sorted in parallel into runs that are spilled to
+// temporary files, then the runs are merged.  Only the keys are parsed into
+// nodes; records are copied byte for byte.  Keys are ordered as in jq, records
+// missing a key sort as though it were null, and the sort is stable.
+class JsonSorter {
+public:
+	explicit JsonSorter(JsonThreadPool& pool) : pool(pool) {
+	}
+
+	JsonSorter& addKey(const std::string& path, bool descending = false) {
+		keys.push_back(Key{JsonPath(path), descending});
+		return *this;
+	}
+
+	// Approximate limit on the memory used for sorting runs
+	JsonSorter& setMemoryLimit(size_t newMemoryLimit) {
+		memoryLimit = newMemoryLimit;
+		return *this;
+	}
+
+	// Most runs merged at once.  More runs are merged over several passes.
+	JsonSorter& setMaxMergeWidth(size_t newMaxMergeWidth) {
+		maxMergeWidth = std::max<size_t>(newMaxMergeWidth, 2);
+		return *this;
+	}
+
+	// Where runs are spilled.  Empty uses the system's temporary directory.
+	JsonSorter& setTempDirectory(const std::string& newTempDirectory) {
+		tempDirectory = newTempDirectory;
+		return *this;
+	}
+
+	// Returns the number of records written
+	uint64_t sort(FILE* input, FILE* output) {
+		if (keys.empty()) {
+			throw JsonException("No sort keys given");
+		}
+		const size_t inFlight = pool.size() + 1;
+		JsonNdjsonProcessor processor(pool);
+		processor.setMaxBlocksInFlight(inFlight);
+		// Each block is held as input, sorted output and keys
+		processor.setBlockSize(std::max<size_t>(memoryLimit / (inFlight * 3), 1 << 16));
+
+		std::vector<RunPtr> runs;
+		processor.processBlocks(input, [this](std::string& block, std::string& run) {
+			sortBlock(block, run);
+		}, [&](const std::string& run) {
+			if (run.empty()) {
+				return;
+			}
+			RunPtr file = openTempFile();
+			if (fwrite(run.data(), 1, run.size(), file.get()) != run.size()) {
+				throw JsonException("Failed to write sorted run");
+			}
+			rewind(file.get());
+			runs.push_back(std::move(file));
+		});
+
+		while (runs.size() > maxMergeWidth) {
+			std::vector<RunPtr> merged;
+			for (size_t i = 0; i < runs.size(); i += maxMergeWidth) {
+				size_t end = std::min(runs.size(), i + maxMergeWidth);
+				RunPtr file = openTempFile();
+				merge(runs, i, end, file.get(), true);
+				rewind(file.get());
+				merged.push_back(std::move(file));
+			}
+			runs.swap(merged);
+		}
+		return merge(runs, 0, runs.size(), output, false);
+	}
+
+private:
+	struct Key {
+		JsonPath path;
+		bool descending;
+	};
+
+	struct FileCloser {
+		void operator()(FILE* file) const {
+			fclose(file);
+		}
+	};
+	using RunPtr = std::unique_ptr<FILE, FileCloser>;
+
+	struct Record {
+		size_t offset;
+		size_t length;
+	};
+
+	JsonThreadPool& pool;
+	std::vector<Key> keys;
+	size_t memoryLimit = 256 << 20;
+	size_t maxMergeWidth = 64;
+	std::string tempDirectory;
+
+	RunPtr openTempFile() const {
+		FILE* file = nullptr;
+#ifndef _WIN32
+		if (!tempDirectory.empty()) {
+			std::string name = tempDirectory + "/jaxup-sort-XXXXXX";
+			int fd = mkstemp(&name[0]);
+			if (fd >= 0) {
+				unlink(name.c_str());
+				file = fdopen(fd, "w+b");
+			}
+		} else {
+			file = std::tmpfile();
+		}
+#else
+		file = std::tmpfile();
+#endif
+		if (file == nullptr) {
+			throw JsonException("Unable to create a temporary file for sorting");
+		}
+		return RunPtr(file);
+	}
+
+	int compareKeys(const JsonNode& a, const JsonNode& b) const {
+		for (size_t i = 0; i < keys.size(); ++i) {
+			int result = compareJsonNodes(a[i], b[i]);
+			if (result != 0) {
+				return keys[i].descending ? -result : result;
+			}
+		}
+		return 0;
+	}
+
+	// Finds a key below a value that was read whole because another key
+	// matched it
+	static const JsonNode* findBelow(const JsonNode& node, const JsonPath& pattern, std::vector<JsonPathElement>& path) {
+		int match = pattern.match(path);
+		if (match & JsonPath::FULL_MATCH) {
+			return &node;
+		}
+		if (!(match & JsonPath::PREFIX_MATCH)) {
+			return nullptr;
+		}
+		const JsonNode* found = nullptr;
+		path.emplace_back();
+		path.back().isIndex = node.getType() == JsonNodeType::VALUE_ARRAY;
+		for (size_t i = 0; i < node.size() && found == nullptr; ++i) {
+			if (path.back().isIndex) {
+				path.back().index = i;
+				found = findBelow(node[i], pattern, path);
+			} else {
+				path.back().name = node.getField(i).first;
+				found = findBelow(node.getField(i).second, pattern, path);
+			}
+		}
+		path.pop_back();
+		return found;
+	}
+
+	// Reads the keys out of the value at the parser's current token, leaving
+	// the parser on the token after it.  The first match of each key wins.
+	template <class source>
+	void extractKeys(JsonParser<source>& parser, std::vector<JsonPathElement>& path, JsonNode& found, size_t& remaining) const {
+		bool full = false;
+		bool prefix = false;
+		for (size_t i = 0; i < keys.size(); ++i) {
+			if (!found[i].isNull()) {
+				continue;
+			}
+			int match = keys[i].path.match(path);
+			full |= (match & JsonPath::FULL_MATCH) != 0;
+			prefix |= (match & JsonPath::PREFIX_MATCH) != 0;
+		}
+		JsonToken token = parser.currentToken();
+		const bool isContainer = token == JsonToken::START_OBJECT || token == JsonToken::START_ARRAY;
+		if (full) {
+			JsonNode value;
+			value.read(parser);
+			std::vector<JsonPathElement> below(path);
+			for (size_t i = 0; i < keys.size(); ++i) {
+				if (found[i].isNull()) {
+					const JsonNode* match = findBelow(value, keys[i].path, below);
+					if (match != nullptr && !match->isNull()) {
+						match->copyTo(found[i]);
+						--remaining;
+					}
+				}
+			}
+			return;
+		}
+		if (!prefix || !isContainer || remaining == 0) {
+			parser.fastSkipChildren();
+			parser.nextToken();
+			return;
+		}
+		const bool isObject = token == JsonToken::START_OBJECT;
+		path.emplace_back();
+		path.back().isIndex = !isObject;
+		size_t index = 0;
+		token = parser.nextToken();
+		while (token != JsonToken::END_OBJECT && token != JsonToken::END_ARRAY) {
+			if (token == JsonToken::NOT_AVAILABLE) {
+				throw JsonException("Unexpected end of stream while reading sort keys");
+			}
+			if (isObject) {
+				path.back().name = parser.getCurrentName();
+				parser.nextToken();
+			} else {
+				path.back().index = index++;
+			}
+			if (remaining == 0) {
+				parser.fastSkipChildren();
+				parser.nextToken();
+			} else {
+				extractKeys(parser, path, found, remaining);
+			}
+			token = parser.currentToken();
+		}
+		path.pop_back();
+		parser.nextToken();
+	}
+
+	static size_t trimmedLength(const std::string& block, size_t offset, size_t end) {
+		while (end > offset && (block[end - 1] == ' ' || block[end - 1] == '\t' || block[end - 1] == '\r' || block[end - 1] == '\n')) {
+			--end;
+		}
+		return end - offset;
+	}
+
+	// Sorts a block of records into a run: for every record, a line holding
+	// its keys as an array followed by the record itself
+	void sortBlock(std::string& block, std::string& run) const {
+		std::vector<Record> records;
+		std::vector<JsonNode> recordKeys;
+		std::vector<JsonPathElement> path;
+		{
+			auto parser = acquireJsonParser(block);
+			parser->nextToken();
+			while (parser->currentToken() != JsonToken::NOT_AVAILABLE) {
+				size_t offset = static_cast<size_t>(parser->getTokenByteOffset());
+				recordKeys.emplace_back();
+				JsonNode& found = recordKeys.back();
+				for (size_t i = 0; i < keys.size(); ++i) {
+					found.append();
+				}
+				size_t remaining = keys.size();
+				path.clear();
+				extractKeys(*parser, path, found, remaining);
+				size_t end = parser->currentToken() == JsonToken::NOT_AVAILABLE ? block.size() : static_cast<size_t>(parser->getTokenByteOffset());
+				records.push_back(Record{offset, trimmedLength(block, offset, end)});
+			}
+		}
+		std::vector<size_t> order(records.size());
+		for (size_t i = 0; i < order.size(); ++i) {
+			order[i] = i;
+		}
+		std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+			return compareKeys(recordKeys[a], recordKeys[b]) < 0;
+		});
+		run.reserve(block.size() + records.size() * (keys.size() * 8 + 4));
+		JsonGenerator<std::string> generator(run, false);
+		for (size_t i : order) {
+			recordKeys[i].write(generator);
+			generator.flush();
+			run.push_back('\n');
+			run.append(block, records[i].offset, records[i].length);
+			run.push_back('\n');
+		}
+	}
+
+	static bool readLine(FILE* file, std::string& line) {
+		line.clear();
+		char buffer[4096];
+		while (fgets(buffer, sizeof(buffer), file) != nullptr) {
+			size_t length = std::strlen(buffer);
+			if (length > 0 && buffer[length - 1] == '\n') {
+				line.append(buffer, length - 1);
+				return true;
+			}
+			line.append(buffer, length);
+		}
+		if (ferror(file)) {
+			throw JsonException("Failed to read sorted run");
+		}
+		return !line.empty();
+	}
+
+	struct Head {
+		JsonNode keys;
+		std::string keysLine;
+		std::string record;
+	};
+
+	// Merges runs [begin, end) into output, keeping the run format when
+	// writing an intermediate run.  Ties go to the earlier run, which keeps
+	// the sort stable.
+	uint64_t merge(std::vector<RunPtr>& runs, size_t begin, size_t end, FILE* output, bool keepKeys) const {
+		std::vector<Head> heads(end - begin);
+		std::string keysLine;
+		JsonParser<std::string> parser(keysLine);
+		auto advance = [&](size_t i) {
+			Head& head = heads[i];
+			if (!readLine(runs[begin + i].get(), head.keysLine)) {
+				return false;
+			}
+			if (!readLine(runs[begin + i].get(), head.record)) {
+				throw JsonException("Truncated sorted run");
+			}
+			parser.reset(head.keysLine);
+			head.keys.read(parser);
+			return true;
+		};
+		auto greater = [&](size_t a, size_t b) {
+			int result = compareKeys(heads[a].keys, heads[b].keys);
+			return result != 0 ? result > 0 : a > b;
+		};
+		std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> queue(greater);
+		for (size_t i = 0; i < heads.size(); ++i) {
+			if (advance(i)) {
+				queue.push(i);
+			}
+		}
+		uint64_t count = 0;
+		while (!queue.empty()) {
+			size_t i = queue.top();
+			queue.pop();
+			const Head& head = heads[i];
+			if (keepKeys) {
+				writeLine(output, head.keysLine);
+			}
+			writeLine(output, head.record);
+			++count;
+			if (advance(i)) {
+				queue.push(i);
+			}
+		}
+		for (size_t i = begin; i < end; ++i) {
+			runs[i].reset();
+		}
+		return count;
+	}
+
+	static void writeLine(FILE* output, const std::string& line) {
+		if (fwrite(line.data(), 1, line.size(), output) != line.size() || fputc('\n', output) == EOF) {
+			throw JsonException("Failed to write sorted output");
+		}
+	}
+};
+}
+
+#endif
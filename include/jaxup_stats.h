@@ -0,0 +1,502 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+
+#ifndef JAXUP_STATS_H
+#define JAXUP_STATS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "jaxup_common.h"
+#include "jaxup_generator.h"
+#include "jaxup_ndjson.h"
+#include "jaxup_parser.h"
+#include "jaxup_thread_pool.h"
+
+namespace jaxup {
+
+// Infers the schema of a stream in one pass: for every path (array elements
+// are written [*]), how often it occurs, which types it holds, the lengths of
+// its strings and arrays, the range of its numbers and how stable the key
+// order of its objects is.  Partial statistics from separate threads can be
+// merged.
+class JsonStatistics {
+public:
+	// Values under paths beyond this many are counted but not described,
+	// which keeps objects used as maps from exhausting memory.
+	JsonStatistics& setMaxPaths(size_t newMaxPaths) {
+		maxPaths = newMaxPaths;
+		return *this;
+	}
+
+	// Visits every top level value in the stream.  Returns the number of
+	// records read.
+	template <class source>
+	uint64_t collect(JsonParser<source>& parser, size_t maxDepth = 50) {
+		uint64_t count = 0;
+		if (parser.currentToken() == JsonToken::NOT_AVAILABLE) {
+			parser.nextToken();
+		}
+		while (parser.currentToken() != JsonToken::NOT_AVAILABLE) {
+			path.clear();
+			visit(parser, maxDepth);
+			++count;
+		}
+		records += count;
+		return count;
+	}
+
+	// Visits newline delimited records on a thread pool, with one partial
+	// result per worker.  Returns the number of records read.
+	uint64_t collect(FILE* input, JsonThreadPool& pool, size_t maxDepth = 50) {
+		std::vector<std::unique_ptr<JsonStatistics>> partials;
+		for (size_t i = 0; i < pool.size(); ++i) {
+			partials.emplace_back(new JsonStatistics);
+			partials.back()->setMaxPaths(maxPaths);
+		}
+		JsonNdjsonProcessor processor(pool);
+		processor.process(input, [&](JsonParser<std::string>& parser, std::string&) {
+			partials[JsonThreadPool::currentWorker()]->collect(parser, maxDepth);
+		}, [](const std::string&) {
+		});
+		uint64_t before = records;
+		for (const auto& partial : partials) {
+			merge(*partial);
+		}
+		return records - before;
+	}
+
+	void merge(const JsonStatistics& other) {
+		records += other.records;
+		untrackedValues += other.untrackedValues;
+		for (const auto& entry : other.fields) {
+			FieldStatistics* stats = find(entry.first, entry.second->parentLength);
+			if (stats == nullptr) {
+				untrackedValues += entry.second->count;
+			} else {
+				stats->merge(*entry.second);
+			}
+		}
+	}
+
+	uint64_t numRecords() const {
+		return records;
+	}
+
+	template <class dest>
+	void write(JsonGenerator<dest>& generator) const {
+		std::map<std::string, const FieldStatistics*> sorted;
+		for (const auto& entry : fields) {
+			sorted.emplace(entry.first, entry.second.get());
+		}
+		generator.startObject();
+		generator.writeField("records", static_cast<int64_t>(records));
+		generator.writeField("untrackedValues", static_cast<int64_t>(untrackedValues));
+		generator.writeFieldName("paths");
+		generator.startObject();
+		for (const auto& entry : sorted) {
+			generator.writeFieldName(entry.first.empty() ? std::string(".") : entry.first);
+			const FieldStatistics* parent = nullptr;
+			if (entry.second->parentLength != noParent) {
+				auto it = fields.find(entry.first.substr(0, entry.second->parentLength));
+				parent = it == fields.end() ? nullptr : it->second.get();
+			}
+			entry.second->write(generator, parent);
+		}
+		generator.endObject();
+		generator.endObject();
+	}
+
+private:
+	static const size_t noParent = static_cast<size_t>(-1);
+	static const size_t maxKeyOrders = 64;
+	static const int numLengthBuckets = 34;
+
+	enum TypeIndex {
+		OBJECT,
+		ARRAY,
+		STRING,
+		INTEGER,
+		FLOAT,
+		BOOLEAN,
+		NULL_VALUE,
+		NUM_TYPES
+	};
+
+	// Bucket 0 holds zero, bucket n holds [2^(n-1), 2^n)
+	static int getLengthBucket(uint64_t length) {
+		int bucket = 0;
+		while (length > 0 && bucket < numLengthBuckets - 1) {
+			length >>= 1;
+			++bucket;
+		}
+		return bucket;
+	}
+
+	static std::string getLengthBucketName(int bucket) {
+		if (bucket <= 1) {
+			return std::to_string(bucket);
+		}
+		uint64_t low = uint64_t(1) << (bucket - 1);
+		return std::to_string(low) + "-" + std::to_string(low * 2 - 1);
+	}
+
+	struct Lengths {
+		uint64_t count = 0;
+		uint64_t sum = 0;
+		uint64_t min = UINT64_MAX;
+		uint64_t max = 0;
+		uint64_t histogram[numLengthBuckets] = {};
+
+		void add(uint64_t length) {
+			++count;
+			sum += length;
+			min = std::min(min, length);
+			max = std::max(max, length);
+			++histogram[getLengthBucket(length)];
+		}
+
+		void merge(const Lengths& other) {
+			count += other.count;
+			sum += other.sum;
+			min = std::min(min, other.min);
+			max = std::max(max, other.max);
+			for (int i = 0; i < numLengthBuckets; ++i) {
+				histogram[i] += other.histogram[i];
+			}
+		}
+
+		template <class dest>
+		void write(JsonGenerator<dest>& generator, const std::string& suffix, const std::string& histogramName) const {
+			generator.writeField("min" + suffix, static_cast<int64_t>(min));
+			generator.writeField("max" + suffix, static_cast<int64_t>(max));
+			generator.writeField("mean" + suffix, static_cast<double>(sum) / static_cast<double>(count));
+			generator.writeFieldName(histogramName);
+			generator.startObject();
+			for (int i = 0; i < numLengthBuckets; ++i) {
+				if (histogram[i] > 0) {
+					generator.writeField(getLengthBucketName(i), static_cast<int64_t>(histogram[i]));
+				}
+			}
+			generator.endObject();
+		}
+	};
+
+	struct FieldStatistics {
+		// Length of the parent's path, for paths of object fields
+		size_t parentLength = noParent;
+		uint64_t count = 0;
+		uint64_t types[NUM_TYPES] = {};
+		Lengths strings;
+		Lengths arrays;
+		Lengths objects;
+		double min = std::numeric_limits<double>::infinity();
+		double max = -std::numeric_limits<double>::infinity();
+		uint64_t int32Count = 0;
+		// Keyed by decimal magnitude, in increasing order of value
+		std::map<int, uint64_t> magnitudes;
+		// Hashes of the key sequences and key sets seen, up to maxKeyOrders
+		std::unordered_map<uint64_t, uint64_t> keyOrders;
+		std::unordered_map<uint64_t, uint64_t> keySets;
+		bool keyOrdersTruncated = false;
+
+		void addNumber(double value, bool isInteger, int64_t integer) {
+			min = std::min(min, value);
+			max = std::max(max, value);
+			if (isInteger && integer >= INT32_MIN && integer <= INT32_MAX) {
+				++int32Count;
+			}
+			int key = 0;
+			if (value != 0.0) {
+				int magnitude = static_cast<int>(std::floor(std::log10(std::abs(value))));
+				key = value > 0 ? magnitude + 400 : -(magnitude + 400);
+			}
+			++magnitudes[key];
+		}
+
+		static void addKeyHash(std::unordered_map<uint64_t, uint64_t>& hashes, uint64_t hash, uint64_t n, bool& truncated) {
+			auto it = hashes.find(hash);
+			if (it != hashes.end()) {
+				it->second += n;
+			} else if (hashes.size() < maxKeyOrders) {
+				hashes.emplace(hash, n);
+			} else {
+				truncated = true;
+			}
+		}
+
+		void merge(const FieldStatistics& other) {
+			count += other.count;
+			for (int i = 0; i < NUM_TYPES; ++i) {
+				types[i] += other.types[i];
+			}
+			strings.merge(other.strings);
+			arrays.merge(other.arrays);
+			objects.merge(other.objects);
+			min = std::min(min, other.min);
+			max = std::max(max, other.max);
+			int32Count += other.int32Count;
+			for (const auto& entry : other.magnitudes) {
+				magnitudes[entry.first] += entry.second;
+			}
+			keyOrdersTruncated |= other.keyOrdersTruncated;
+			for (const auto& entry : other.keyOrders) {
+				addKeyHash(keyOrders, entry.first, entry.second, keyOrdersTruncated);
+			}
+			for (const auto& entry : other.keySets) {
+				addKeyHash(keySets, entry.first, entry.second, keyOrdersTruncated);
+			}
+		}
+
+		static std::string getMagnitudeName(int key) {
+			if (key == 0) {
+				return "0";
+			}
+			int magnitude = std::abs(key) - 400;
+			if (key < 0) {
+				return "-1e" + std::to_string(magnitude + 1) + "..-1e" + std::to_string(magnitude);
+			}
+			return "1e" + std::to_string(magnitude) + "..1e" + std::to_string(magnitude + 1);
+		}
+
+		template <class dest>
+		void write(JsonGenerator<dest>& generator, const FieldStatistics* parent) const {
+			static const char* typeNames[NUM_TYPES] = {"object", "array", "string", "integer", "float", "boolean", "null"};
+			generator.startObject();
+			generator.writeField("count", static_cast<int64_t>(count));
+			if (parent != nullptr && parent->types[OBJECT] > 0) {
+				generator.writeField("presence", static_cast<double>(count) / static_cast<double>(parent->types[OBJECT]));
+			}
+			generator.writeField("nullRate", static_cast<double>(types[NULL_VALUE]) / static_cast<double>(count));
+			generator.writeFieldName("types");
+			generator.startObject();
+			for (int i = 0; i < NUM_TYPES; ++i) {
+				if (types[i] > 0) {
+					generator.writeField(typeNames[i], static_cast<int64_t>(types[i]));
+				}
+			}
+			generator.endObject();
+			if (strings.count > 0) {
+				generator.writeFieldName("string");
+				generator.startObject();
+				strings.write(generator, "Length", "lengthHistogram");
+				generator.endObject();
+			}
+			if (types[INTEGER] + types[FLOAT] > 0) {
+				generator.writeFieldName("number");
+				generator.startObject();
+				generator.writeField("min", min);
+				generator.writeField("max", max);
+				generator.writeField("int32", static_cast<int64_t>(int32Count));
+				generator.writeFieldName("magnitudeHistogram");
+				generator.startObject();
+				for (const auto& entry : magnitudes) {
+					generator.writeField(getMagnitudeName(entry.first), static_cast<int64_t>(entry.second));
+				}
+				generator.endObject();
+				generator.endObject();
+			}
+			if (arrays.count > 0) {
+				generator.writeFieldName("array");
+				generator.startObject();
+				arrays.write(generator, "Length", "lengthHistogram");
+				generator.endObject();
+			}
+			if (objects.count > 0) {
+				uint64_t dominant = 0;
+				for (const auto& entry : keyOrders) {
+					dominant = std::max(dominant, entry.second);
+				}
+				generator.writeFieldName("object");
+				generator.startObject();
+				objects.write(generator, "Keys", "keyCountHistogram");
+				generator.writeField("keyOrders", static_cast<int64_t>(keyOrders.size()));
+				generator.writeField("keySets", static_cast<int64_t>(keySets.size()));
+				generator.writeField("keyOrdersTruncated", keyOrdersTruncated);
+				generator.writeField("dominantKeyOrderShare", static_cast<double>(dominant) / static_cast<double>(objects.count));
+				generator.writeField("stableKeyOrder", keyOrders.size() == 1 && !keyOrdersTruncated);
+				generator.endObject();
+			}
+			generator.endObject();
+		}
+	};
+
+	std::unordered_map<std::string, std::unique_ptr<FieldStatistics>> fields;
+	size_t maxPaths = 10000;
+	uint64_t records = 0;
+	uint64_t untrackedValues = 0;
+	std::string path;
+
+	FieldStatistics* find(const std::string& key, size_t parentLength = noParent) {
+		auto it = fields.find(key);
+		if (it != fields.end()) {
+			return it->second.get();
+		}
+		if (fields.size() >= maxPaths) {
+			return nullptr;
+		}
+		std::unique_ptr<FieldStatistics> stats(new FieldStatistics);
+		stats->parentLength = parentLength;
+		FieldStatistics* result = stats.get();
+		fields.emplace(key, std::move(stats));
+		return result;
+	}
+
+	static bool isPlainName(const std::string& name) {
+		if (name.empty() || (name[0] >= '0' && name[0] <= '9')) {
+			return false;
+		}
+		for (char c : name) {
+			if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_')) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void appendName(const std::string& name) {
+		if (isPlainName(name)) {
+			path += '.';
+			path += name;
+			return;
+		}
+		path += "[\"";
+		for (char c : name) {
+			if (c == '"' || c == '\\') {
+				path += '\\';
+			}
+			path += c;
+		}
+		path += "\"]";
+	}
+
+	static uint64_t hashName(uint64_t hash, const std::string& name) {
+		for (char c : name) {
+			hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+		}
+		return (hash ^ 0xff) * 1099511628211ULL;
+	}
+
+	// Visits the value at the parser's current token, leaving the parser on
+	// the token after it
+	template <class source>
+	void visit(JsonParser<source>& parser, size_t maxDepth, size_t parentLength = noParent) {
+		FieldStatistics* stats = find(path, parentLength);
+		if (stats == nullptr) {
+			++untrackedValues;
+			parser.fastSkipChildren();
+			parser.nextToken();
+			return;
+		}
+		++stats->count;
+		JsonToken token = parser.currentToken();
+		switch (token) {
+		case JsonToken::START_OBJECT: {
+			if (maxDepth == 0) {
+				throw JsonException("Max depth exceeded while collecting statistics");
+			}
+			++stats->types[OBJECT];
+			const size_t length = path.size();
+			uint64_t orderHash = 14695981039346656037ULL;
+			uint64_t setHash = 0;
+			uint64_t numKeys = 0;
+			parser.nextToken();
+			while (parser.currentToken() == JsonToken::FIELD_NAME) {
+				const std::string& name = parser.getCurrentName();
+				orderHash = hashName(orderHash, name);
+				setHash += hashName(14695981039346656037ULL, name);
+				++numKeys;
+				appendName(name);
+				parser.nextToken();
+				visit(parser, maxDepth - 1, length);
+				path.resize(length);
+			}
+			if (parser.currentToken() != JsonToken::END_OBJECT) {
+				throw JsonException("Unexpected end of stream while collecting statistics");
+			}
+			stats->objects.add(numKeys);
+			FieldStatistics::addKeyHash(stats->keyOrders, orderHash, 1, stats->keyOrdersTruncated);
+			FieldStatistics::addKeyHash(stats->keySets, setHash, 1, stats->keyOrdersTruncated);
+			parser.nextToken();
+		} break;
+		case JsonToken::START_ARRAY: {
+			if (maxDepth == 0) {
+				throw JsonException("Max depth exceeded while collecting statistics");
+			}
+			++stats->types[ARRAY];
+			const size_t length = path.size();
+			path += "[*]";
+			uint64_t numElements = 0;
+			parser.nextToken();
+			while (parser.currentToken() != JsonToken::END_ARRAY) {
+				if (parser.currentToken() == JsonToken::NOT_AVAILABLE) {
+					throw JsonException("Unexpected end of stream while collecting statistics");
+				}
+				visit(parser, maxDepth - 1);
+				++numElements;
+			}
+			path.resize(length);
+			stats->arrays.add(numElements);
+			parser.nextToken();
+		} break;
+		case JsonToken::VALUE_STRING:
+			++stats->types[STRING];
+			stats->strings.add(parser.getText().size());
+			parser.nextToken();
+			break;
+		case JsonToken::VALUE_NUMBER_INT:
+			++stats->types[INTEGER];
+			stats->addNumber(parser.getDoubleValue(), true, parser.getIntegerValue());
+			parser.nextToken();
+			break;
+		case JsonToken::VALUE_NUMBER_FLOAT:
+			++stats->types[FLOAT];
+			stats->addNumber(parser.getDoubleValue(), false, 0);
+			parser.nextToken();
+			break;
+		case JsonToken::VALUE_TRUE:
+		case JsonToken::VALUE_FALSE:
+			++stats->types[BOOLEAN];
+			parser.nextToken();
+			break;
+		case JsonToken::VALUE_NULL:
+			++stats->types[NULL_VALUE];
+			parser.nextToken();
+			break;
+		default:
+			throw JsonException("Unexpected ", getTokenAsString(token), " while collecting statistics");
+		}
+	}
+};
+}
+
+#endif
@@ -0,0 +1,173 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#ifndef JAXUP_THREAD_POOL_H
+#define JAXUP_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace jaxup {
+
+// A small work stealing pool.  Every worker owns a deque; it takes its own work
+// from the back and, when that runs dry, steals from the front of the others.
+// Tasks are expected to handle their own exceptions.
+class JsonThreadPool {
+public:
+	static const size_t notAWorker = static_cast<size_t>(-1);
+
+	explicit JsonThreadPool(size_t numThreads = 0) {
+		if (numThreads == 0) {
+			numThreads = std::thread::hardware_concurrency();
+			if (numThreads == 0) {
+				numThreads = 1;
+			}
+		}
+		queues.reserve(numThreads);
+		for (size_t i = 0; i < numThreads; ++i) {
+			queues.emplace_back(new WorkQueue);
+		}
+		threads.reserve(numThreads);
+		for (size_t i = 0; i < numThreads; ++i) {
+			threads.emplace_back(&JsonThreadPool::run, this, i);
+		}
+	}
+
+	JsonThreadPool(const JsonThreadPool&) = delete;
+	JsonThreadPool& operator=(const JsonThreadPool&) = delete;
+
+	~JsonThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	}
+
+	size_t size() const {
+		return threads.size();
+	}
+
+	void submit(std::function<void()> task) {
+		size_t target = currentWorkerIndex();
+		if (target == notAWorker || getCurrentPool() != this) {
+			target = nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+		}
+		{
+			std::lock_guard<std::mutex> lock(queues[target]->mutex);
+			queues[target]->tasks.push_back(std::move(task));
+		}
+		pending.fetch_add(1, std::memory_order_release);
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+		}
+		wake.notify_one();
+	}
+
+	// Index of the pool worker running the calling thread, or notAWorker.
+	// Handy for keeping per-worker scratch objects.
+	static size_t currentWorker() {
+		return currentWorkerIndex();
+	}
+
+private:
+	struct WorkQueue {
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	std::vector<std::unique_ptr<WorkQueue>> queues;
+	std::vector<std::thread> threads;
+	std::atomic<size_t> nextQueue{0};
+	std::atomic<size_t> pending{0};
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+	bool stopping = false;
+
+	static size_t& currentWorkerIndex() {
+		static thread_local size_t index = notAWorker;
+		return index;
+	}
+
+	static JsonThreadPool*& getCurrentPool() {
+		static thread_local JsonThreadPool* pool = nullptr;
+		return pool;
+	}
+
+	bool takeTask(size_t self, std::function<void()>& task) {
+		{
+			WorkQueue& own = *queues[self];
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if (!own.tasks.empty()) {
+				task = std::move(own.tasks.back());
+				own.tasks.pop_back();
+				pending.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+		for (size_t i = 1; i < queues.size(); ++i) {
+			WorkQueue& victim = *queues[(self + i) % queues.size()];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.tasks.empty()) {
+				task = std::move(victim.tasks.front());
+				victim.tasks.pop_front();
+				pending.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void run(size_t self) {
+		currentWorkerIndex() = self;
+		getCurrentPool() = this;
+		std::function<void()> task;
+		for (;;) {
+			if (takeTask(self, task)) {
+				task();
+				task = nullptr;
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			if (pending.load(std::memory_order_acquire) > 0) {
+				continue;
+			}
+			if (stopping) {
+				return;
+			}
+			wake.wait(lock);
+		}
+	}
+};
+}
+
+#endif
@@ -0,0 +1,279 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#ifndef JAXUP_BATCH_H
+#define JAXUP_BATCH_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include <jaxup.h>
+
+// Shared plumbing for the command line tools' --batch modes.
+
+struct BatchOptions {
+	std::vector<std::string> inputs;
+	// Where each input is written below outputDir: its path relative to the
+	// directory it was found in, or its base name if it was named directly
+	std::vector<std::string> outputNames;
+	std::string outputDir;
+	size_t threads = 0;
+	bool prettify = false;
+};
+
+struct BatchFileResult {
+	uint64_t bytes = 0;
+	uint64_t items = 0;
+};
+
+static inline bool isDirectory(const std::string& path) {
+#ifdef _WIN32
+	DWORD attributes = GetFileAttributesA(path.c_str());
+	return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+	struct stat info;
+	return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+#endif
+}
+
+static inline void listFiles(const std::string& path, const std::string& outputName, BatchOptions& options) {
+	if (!isDirectory(path)) {
+		options.inputs.push_back(path);
+		options.outputNames.push_back(outputName);
+		return;
+	}
+	std::vector<std::string> children;
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE handle = FindFirstFileA((path + "\\*").c_str(), &data);
+	if (handle == INVALID_HANDLE_VALUE) {
+		return;
+	}
+	do {
+		children.push_back(data.cFileName);
+	} while (FindNextFileA(handle, &data));
+	FindClose(handle);
+#else
+	DIR* dir = opendir(path.c_str());
+	if (dir == nullptr) {
+		return;
+	}
+	while (struct dirent* entry = readdir(dir)) {
+		children.push_back(entry->d_name);
+	}
+	closedir(dir);
+#endif
+	for (const auto& child : children) {
+		if (child != "." && child != "..") {
+			listFiles(path + "/" + child, outputName.empty() ? child : outputName + "/" + child, options);
+		}
+	}
+}
+
+static inline std::string getBaseName(const std::string& path) {
+	size_t slash = path.find_last_of("/\\");
+	return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+// Fails quietly if the directory exists, so callers check the result some
+// other way
+static inline void makeDirectory(const std::string& path) {
+#ifdef _WIN32
+	CreateDirectoryA(path.c_str(), nullptr);
+#else
+	mkdir(path.c_str(), 0777);
+#endif
+}
+
+// Creates a directory and any missing parents.  Returns whether it exists.
+static inline bool makeDirectories(const std::string& path) {
+	for (size_t slash = path.find_first_of("/\\", 1); slash != std::string::npos; slash = path.find_first_of("/\\", slash + 1)) {
+		makeDirectory(path.substr(0, slash));
+	}
+	makeDirectory(path);
+	return isDirectory(path);
+}
+
+// Opens outputDir/outputName for writing, creating any directories below
+// outputDir that it needs
+static inline FILE* openBatchOutput(const BatchOptions& options, const std::string& outputName) {
+	for (size_t slash = outputName.find('/'); slash != std::string::npos; slash = outputName.find('/', slash + 1)) {
+		// Other workers may be creating the same directory, so only fopen's
+		// result matters
+		makeDirectory(options.outputDir + "/" + outputName.substr(0, slash));
+	}
+	std::string outputPath = options.outputDir + "/" + outputName;
+	FILE* file = fopen(outputPath.c_str(), "w");
+	if (file == nullptr) {
+		throw jaxup::JsonException("Unable to open output file ", outputPath);
+	}
+	return file;
+}
+
+// Reports inputs that would be written to the same output
+static inline bool checkOutputNames(const BatchOptions& options) {
+	std::vector<size_t> order(options.inputs.size());
+	for (size_t i = 0; i < order.size(); ++i) {
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&options](size_t a, size_t b) {
+		return options.outputNames[a] < options.outputNames[b];
+	});
+	for (size_t i = 1; i < order.size(); ++i) {
+		if (options.outputNames[order[i]] == options.outputNames[order[i - 1]]) {
+			std::cerr << options.inputs[order[i - 1]] << " and " << options.inputs[order[i]] << " would both be written to "
+				<< options.outputDir << "/" << options.outputNames[order[i]] << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+static inline uint64_t getFileSize(FILE* file) {
+	if (fseek(file, 0, SEEK_END) != 0) {
+		return 0;
+	}
+	long size = ftell(file);
+	rewind(file);
+	return size < 0 ? 0 : static_cast<uint64_t>(size);
+}
+
+// Copies one input to its output with the tool's copy function, which
+// returns the number of items copied
+static inline BatchFileResult copyBatchFile(const std::string& input, const std::string& outputName, const BatchOptions& options,
+	int (*copy)(FILE* inputFile, FILE* outputFile, bool prettify)) {
+	BatchFileResult result;
+	FILE* inputFile = fopen(input.c_str(), "r");
+	if (inputFile == nullptr) {
+		throw jaxup::JsonException("Unable to open file");
+	}
+	FILE* outputFile;
+	try {
+		outputFile = openBatchOutput(options, outputName);
+	} catch (...) {
+		fclose(inputFile);
+		throw;
+	}
+	result.bytes = getFileSize(inputFile);
+	try {
+		result.items = copy(inputFile, outputFile, options.prettify);
+	} catch (...) {
+		fclose(inputFile);
+		fclose(outputFile);
+		throw;
+	}
+	fclose(inputFile);
+	fclose(outputFile);
+	return result;
+}
+
+// Parses "[--threads N] [--prettify] paths..." following --batch.
+static inline bool parseBatchArgs(int argc, char* argv[], int first, bool needsOutputDir, BatchOptions& options) {
+	int arg = first;
+	if (needsOutputDir) {
+		if (arg >= argc) {
+			return false;
+		}
+		options.outputDir = argv[arg++];
+	}
+	for (; arg < argc; ++arg) {
+		if (std::strcmp(argv[arg], "--threads") == 0 && arg + 1 < argc) {
+			options.threads = std::strtoul(argv[++arg], nullptr, 10);
+		} else if (std::strcmp(argv[arg], "--prettify") == 0) {
+			options.prettify = true;
+		} else {
+			listFiles(argv[arg], isDirectory(argv[arg]) ? "" : getBaseName(argv[arg]), options);
+		}
+	}
+	return !options.inputs.empty() && (!needsOutputDir || checkOutputNames(options));
+}
+
+// Processes every input on a work stealing pool and reports aggregate
+// throughput.  Returns the number of files that failed.
+static inline int runBatch(const BatchOptions& options, const char* itemName,
+	std::function<BatchFileResult(const std::string& input, const std::string& outputName)> process) {
+	if (!options.outputDir.empty() && !makeDirectories(options.outputDir)) {
+		std::cerr << "Unable to create output directory " << options.outputDir << std::endl;
+		return static_cast<int>(options.inputs.size());
+	}
+	auto start = std::chrono::high_resolution_clock::now();
+	std::atomic<uint64_t> totalBytes(0);
+	std::atomic<uint64_t> totalItems(0);
+	std::atomic<int> failures(0);
+	size_t remaining = options.inputs.size();
+	std::mutex mutex;
+	std::condition_variable finished;
+	{
+		jaxup::JsonThreadPool pool(options.threads);
+		for (size_t i = 0; i < options.inputs.size(); ++i) {
+			const std::string& input = options.inputs[i];
+			const std::string& outputName = options.outputNames[i];
+			pool.submit([&, input, outputName]() {
+				try {
+					BatchFileResult result = process(input, outputName);
+					totalBytes += result.bytes;
+					totalItems += result.items;
+				} catch (const std::exception& e) {
+					std::lock_guard<std::mutex> lock(mutex);
+					std::cerr << "Failed to process " << input << ": " << e.what() << std::endl;
+					++failures;
+				}
+				std::lock_guard<std::mutex> lock(mutex);
+				if (--remaining == 0) {
+					finished.notify_all();
+				}
+			});
+		}
+		std::unique_lock<std::mutex> lock(mutex);
+		finished.wait(lock, [&remaining]() { return remaining == 0; });
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+	std::cout << "Files: " << options.inputs.size() << " (" << failures << " failed)" << std::endl;
+	std::cout << "Microseconds: " << duration << std::endl;
+	std::cout << "Total bytes: " << totalBytes << std::endl;
+	std::cout << "Total " << itemName << " count: " << totalItems << std::endl;
+	if (duration > 0) {
+		std::cout << "Throughput (MB/s): " << static_cast<double>(totalBytes) / static_cast<double>(duration) << std::endl;
+	}
+	return failures;
+}
+
+#endif
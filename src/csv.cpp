@@ -0,0 +1,130 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <jaxup.h>
+
+using namespace jaxup;
+
+int usage(const char* name) {
+	std::cerr << "Expected format: " << name << " inputFile [outputFile] (--column path [--as name])... [--tsv] [--crlf]" << std::endl;
+	std::cerr << "       [--no-header] [--unwrap] [--ndjson] [--threads N]" << std::endl;
+	return 1;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 4) {
+		return usage(argv[0]);
+	}
+	const char* outputPath = nullptr;
+	bool ndjson = false;
+	bool header = true;
+	size_t threads = 0;
+	JsonCsvWriter writer;
+	std::vector<std::pair<std::string, std::string>> columns;
+	for (int arg = 2; arg < argc; ++arg) {
+		if (std::strcmp(argv[arg], "--column") == 0 && arg + 1 < argc) {
+			columns.emplace_back(argv[++arg], "");
+		} else if (std::strcmp(argv[arg], "--as") == 0 && arg + 1 < argc && !columns.empty()) {
+			columns.back().second = argv[++arg];
+		} else if (std::strcmp(argv[arg], "--tsv") == 0) {
+			writer.setDelimiter('\t');
+		} else if (std::strcmp(argv[arg], "--crlf") == 0) {
+			writer.setLineTerminator("\r\n");
+		} else if (std::strcmp(argv[arg], "--no-header") == 0) {
+			header = false;
+		} else if (std::strcmp(argv[arg], "--unwrap") == 0) {
+			writer.setUnwrapArrays(true);
+		} else if (std::strcmp(argv[arg], "--ndjson") == 0) {
+			ndjson = true;
+		} else if (std::strcmp(argv[arg], "--threads") == 0 && arg + 1 < argc) {
+			threads = std::strtoul(argv[++arg], nullptr, 10);
+		} else if (outputPath == nullptr && argv[arg][0] != '-') {
+			outputPath = argv[arg];
+		} else {
+			return usage(argv[0]);
+		}
+	}
+	try {
+		for (const auto& column : columns) {
+			writer.addColumn(column.first, column.second);
+		}
+	} catch (const JsonException& e) {
+		std::cerr << e.what() << std::endl;
+		return usage(argv[0]);
+	}
+	if (writer.numColumns() == 0) {
+		return usage(argv[0]);
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	FILE* inputFile = fopen(argv[1], "rb");
+	if (inputFile == nullptr) {
+		std::cerr << "Unable to open " << argv[1] << std::endl;
+		return 1;
+	}
+	FILE* outputFile = stdout;
+	if (outputPath != nullptr) {
+		outputFile = fopen(outputPath, "wb");
+		if (outputFile == nullptr) {
+			std::cerr << "Unable to open " << outputPath << std::endl;
+			return 1;
+		}
+	}
+	uint64_t numRows = 0;
+	try {
+		if (header) {
+			std::string headerRow;
+			writer.writeHeader(headerRow);
+			fwrite(headerRow.data(), 1, headerRow.size(), outputFile);
+		}
+		if (ndjson) {
+			JsonThreadPool pool(threads);
+			numRows = writer.convert(inputFile, outputFile, pool);
+		} else {
+			JsonPooledFactory factory;
+			auto parser = factory.createJsonParser(inputFile);
+			numRows = writer.convert(*parser, outputFile);
+		}
+	} catch (const JsonException& e) {
+		std::cerr << "Failed to convert: " << e.what() << std::endl;
+		return 1;
+	}
+	fclose(inputFile);
+	if (outputFile != stdout) {
+		fclose(outputFile);
+	} else {
+		fflush(stdout);
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+	std::cerr << "Microseconds: " << duration << std::endl;
+	std::cerr << "Total row count: " << numRows << std::endl;
+	return 0;
+}
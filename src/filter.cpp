@@ -0,0 +1,80 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <jaxup.h>
+
+using namespace jaxup;
+
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		std::cerr << "Expected format: " << argv[0] << " inputFile outputFile [--include path]... [--exclude path]... [--prettify]" << std::endl;
+		return 1;
+	}
+	auto start = std::chrono::high_resolution_clock::now();
+	FILE* inputFile = fopen(argv[1], "r");
+	if (inputFile == nullptr) {
+		std::cerr << "Unable to open " << argv[1] << std::endl;
+		return 1;
+	}
+	FILE* outputFile = fopen(argv[2], "w");
+	if (outputFile == nullptr) {
+		std::cerr << "Unable to open " << argv[2] << std::endl;
+		return 1;
+	}
+	bool prettify = false;
+	JsonFilter filter;
+	size_t numValues = 0;
+	try {
+		for (int arg = 3; arg < argc; ++arg) {
+			if (std::strcmp(argv[arg], "--include") == 0 && arg + 1 < argc) {
+				filter.include(argv[++arg]);
+			} else if (std::strcmp(argv[arg], "--exclude") == 0 && arg + 1 < argc) {
+				filter.exclude(argv[++arg]);
+			} else if (std::strcmp(argv[arg], "--prettify") == 0) {
+				prettify = true;
+			} else {
+				std::cerr << "Unknown argument: " << argv[arg] << std::endl;
+				return 1;
+			}
+		}
+		JsonFactory factory;
+		auto parser = factory.createJsonParser(inputFile);
+		auto generator = factory.createJsonGenerator(outputFile, prettify);
+		generator->setRootValueSeparator("\n");
+		numValues = filter.copy(*parser, *generator);
+	} catch (const JsonException& e) {
+		std::cerr << "Failed to filter file: " << e.what() << std::endl;
+		return 1;
+	}
+	fclose(inputFile);
+	fclose(outputFile);
+
+	auto end = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+	std::cerr << "Microseconds: " << duration << std::endl;
+	std::cerr << "Total root value count: " << numValues << std::endl;
+	return 0;
+}
@@ -0,0 +1,113 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <jaxup.h>
+
+using namespace jaxup;
+
+struct FileCloser {
+	void operator()(FILE* file) const {
+		fclose(file);
+	}
+};
+// Closes the file on every way out of main
+using FilePtr = std::unique_ptr<FILE, FileCloser>;
+
+int usage(const char* name) {
+	std::cerr << "Expected format: " << name << " build inputFile [--ndjson] [--index indexFile]" << std::endl;
+	std::cerr << "             or: " << name << " get inputFile elementNumber [--index indexFile] [--prettify]" << std::endl;
+	return 1;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		return usage(argv[0]);
+	}
+	std::string command = argv[1];
+	std::string inputPath = argv[2];
+	std::string indexPath = inputPath + ".idx";
+	bool ndjson = false;
+	bool prettify = false;
+	const char* element = nullptr;
+	for (int arg = 3; arg < argc; ++arg) {
+		if (std::strcmp(argv[arg], "--index") == 0 && arg + 1 < argc) {
+			indexPath = argv[++arg];
+		} else if (std::strcmp(argv[arg], "--ndjson") == 0) {
+			ndjson = true;
+		} else if (std::strcmp(argv[arg], "--prettify") == 0) {
+			prettify = true;
+		} else {
+			element = argv[arg];
+		}
+	}
+
+	FilePtr inputFile(fopen(inputPath.c_str(), "rb"));
+	if (!inputFile) {
+		std::cerr << "Unable to open " << inputPath << std::endl;
+		return 1;
+	}
+	JsonFactory factory;
+	auto parser = factory.createJsonParser(inputFile.get());
+	JsonIndex index;
+	try {
+		if (command == "build") {
+			auto start = std::chrono::high_resolution_clock::now();
+			index.build(*parser, ndjson ? JsonIndexLayout::SEQUENCE : JsonIndexLayout::ARRAY);
+			FilePtr indexFile(fopen(indexPath.c_str(), "wb"));
+			if (!indexFile) {
+				std::cerr << "Unable to open " << indexPath << std::endl;
+				return 1;
+			}
+			index.save(indexFile.get());
+			indexFile.reset();
+			auto end = std::chrono::high_resolution_clock::now();
+			auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+			std::cout << "Microseconds: " << duration << std::endl;
+			std::cout << "Total element count: " << index.size() << std::endl;
+		} else if (command == "get" && element != nullptr) {
+			FilePtr indexFile(fopen(indexPath.c_str(), "rb"));
+			if (!indexFile) {
+				std::cerr << "Unable to open " << indexPath << std::endl;
+				return 1;
+			}
+			index.load(indexFile.get());
+			indexFile.reset();
+			JsonNode node;
+			index.read(*parser, std::strtoull(element, nullptr, 10), node);
+			auto generator = factory.createJsonGenerator(stdout, prettify);
+			node.write(*generator);
+			generator->flush();
+			std::cout << std::endl;
+		} else {
+			return usage(argv[0]);
+		}
+	} catch (const JsonException& e) {
+		std::cerr << "Failed to use index: " << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
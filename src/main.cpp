@@ -25,13 +25,48 @@
 #include <iostream>
 #include <jaxup.h>
 
+#include "batch.h"
+
 using namespace jaxup;
 
+BatchFileResult countTokens(const std::string& input) {
+	BatchFileResult result;
+	FILE* inputFile = fopen(input.c_str(), "r");
+	if (inputFile == nullptr) {
+		throw JsonException("Unable to open file");
+	}
+	setbuf(inputFile, nullptr);
+	result.bytes = getFileSize(inputFile);
+	try {
+		JsonPooledFactory factory;
+		auto parser = factory.createJsonParser(inputFile);
+		while (parser->nextToken() != JsonToken::NOT_AVAILABLE) {
+			++result.items;
+		}
+	} catch (...) {
+		fclose(inputFile);
+		throw;
+	}
+	fclose(inputFile);
+	return result;
+}
+
 int main(int argc, char* argv[]) {
 	if (argc < 2) {
 		std::cerr << "Expected format: " << argv[0] << " inputFile" << std::endl;
+		std::cerr << "             or: " << argv[0] << " --batch [--threads N] inputFilesOrDirectories..." << std::endl;
 		return 1;
 	}
+	if (std::string("--batch") == argv[1]) {
+		BatchOptions options;
+		if (!parseBatchArgs(argc, argv, 2, false, options)) {
+			std::cerr << "No input files given" << std::endl;
+			return 1;
+		}
+		return runBatch(options, "token", [](const std::string& input, const std::string&) {
+			return countTokens(input);
+		}) == 0 ? 0 : 1;
+	}
 	int error = 0;
 	auto start = std::chrono::high_resolution_clock::now();
 	//std::ifstream inputFile(argv[1]);
@@ -25,15 +25,18 @@
 #include <iostream>
 #include <jaxup.h>
 
+#include "batch.h"
+
 using namespace jaxup;
 
 int streamingCopy(FILE* inputFile, FILE* outputFile, bool prettify) {
-	JsonFactory factory;
+	JsonPooledFactory factory;
 	auto parser = factory.createJsonParser(inputFile);
 	auto generator = factory.createJsonGenerator(outputFile, prettify);
 	JsonNode node;
 	int i = 0;
-	while (parser->nextToken() != JsonToken::NOT_AVAILABLE) {
+	parser->nextToken();
+	while (parser->currentToken() != JsonToken::NOT_AVAILABLE) {
 		node.read(*parser);
 		node.write(*generator);
 		++i;
@@ -43,8 +46,22 @@ int streamingCopy(FILE* inputFile, FILE* outputFile, bool prettify) {
 }
 
 int main(int argc, char* argv[]) {
+	if (argc > 1 && std::string("--batch") == argv[1]) {
+		BatchOptions options;
+		if (!parseBatchArgs(argc, argv, 2, true, options)) {
+			std::cerr << "Expected format: " << argv[0] << " --batch outputDir [--threads N] [--prettify] inputFilesOrDirectories..." << std::endl;
+			return 1;
+		}
+		return runBatch(options, "root node", [&options](const std::string& input, const std::string& outputName) {
+			return copyBatchFile(input, outputName, options, streamingCopy);
+		}) == 0 ? 0 : 1;
+	}
 	if (argc < 3) {
-		std::cerr << "Expected format: " << argv[0] << " inputFile outputFile" << std::endl;
+#ifdef JAXUP_USE_NODE_RECYCLER
+		std::cerr << "Expected format: " << argv[0] << " inputFile outputFile [--prettify] [--recycle]" << std::endl;
+#else
+		std::cerr << "Expected format: " << argv[0] << " inputFile outputFile [--prettify]" << std::endl;
+#endif
 		return 1;
 	}
 	auto start = std::chrono::high_resolution_clock::now();
@@ -53,8 +70,21 @@ int main(int argc, char* argv[]) {
 	FILE* inputFile = fopen(argv[1], "r");
 	FILE* outputFile = fopen(argv[2], "w");
 	bool prettify = false;
-	if (argc > 3 && std::string("--prettify") == argv[3]) {
-		prettify = true;
+#ifdef JAXUP_USE_NODE_RECYCLER
+	// Keeps freed nodes' buffers for the next document rather than freeing them
+	std::unique_ptr<JsonNodeRecycler> recycler;
+#endif
+	for (int i = 3; i < argc; ++i) {
+		if (std::string("--prettify") == argv[i]) {
+			prettify = true;
+		} else if (std::string("--recycle") == argv[i]) {
+#ifdef JAXUP_USE_NODE_RECYCLER
+			recycler.reset(new JsonNodeRecycler);
+#else
+			std::cerr << "Recycling is only compiled into nodeCopyRecycled" << std::endl;
+			return 1;
+#endif
+		}
 	}
 
 	int numRootNodes = 0;
@@ -71,6 +101,12 @@ int main(int argc, char* argv[]) {
 						.count();
 	std::cout << "Microseconds: " << duration << std::endl;
 	std::cout << "Total root node count: " << numRootNodes << std::endl;
+#ifdef JAXUP_USE_NODE_RECYCLER
+	if (recycler) {
+		std::cout << "Total allocation count: " << recycler->numAllocations() << std::endl;
+		std::cout << "Total recycled count: " << recycler->numRecycled() << std::endl;
+	}
+#endif
 
 	return 0;
 }
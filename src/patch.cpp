@@ -0,0 +1,117 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <jaxup.h>
+
+using namespace jaxup;
+
+int usage(const char* name) {
+	std::cerr << "Expected format: " << name << " inputFile patchFile [outputFile] [--merge] [--stats]" << std::endl;
+	return 1;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		return usage(argv[0]);
+	}
+	const char* outputPath = nullptr;
+	bool merge = false;
+	bool stats = false;
+	for (int arg = 3; arg < argc; ++arg) {
+		if (std::strcmp(argv[arg], "--merge") == 0) {
+			merge = true;
+		} else if (std::strcmp(argv[arg], "--stats") == 0) {
+			stats = true;
+		} else if (outputPath == nullptr && argv[arg][0] != '-') {
+			outputPath = argv[arg];
+		} else {
+			return usage(argv[0]);
+		}
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	FILE* patchFile = fopen(argv[2], "rb");
+	if (patchFile == nullptr) {
+		std::cerr << "Unable to open " << argv[2] << std::endl;
+		return 1;
+	}
+	JsonPooledFactory factory;
+	JsonNode patch;
+	std::unique_ptr<JsonStreamingPatcher> patcher;
+	try {
+		auto patchParser = factory.createJsonParser(patchFile);
+		patch.read(*patchParser);
+		patcher.reset(new JsonStreamingPatcher(merge ? JsonStreamingPatcher::fromMergePatch(patch) : JsonStreamingPatcher::fromJsonPatch(patch)));
+	} catch (const JsonException& e) {
+		std::cerr << "Invalid patch: " << e.what() << std::endl;
+		return 1;
+	}
+	fclose(patchFile);
+
+	FILE* inputFile = fopen(argv[1], "rb");
+	if (inputFile == nullptr) {
+		std::cerr << "Unable to open " << argv[1] << std::endl;
+		return 1;
+	}
+	FILE* outputFile = stdout;
+	if (outputPath != nullptr) {
+		outputFile = fopen(outputPath, "wb");
+		if (outputFile == nullptr) {
+			std::cerr << "Unable to open " << outputPath << std::endl;
+			return 1;
+		}
+	}
+	uint64_t count = 0;
+	try {
+		auto parser = factory.createJsonParser(inputFile);
+		auto generator = factory.createJsonGenerator(outputFile, false);
+		generator->setRootValueSeparator("\n");
+		count = patcher->apply(*parser, *generator);
+		generator->flush();
+		if (count > 0) {
+			fputc('\n', outputFile);
+		}
+	} catch (const JsonException& e) {
+		std::cerr << "Failed to patch: " << e.what() << std::endl;
+		return 1;
+	}
+	fclose(inputFile);
+	if (outputFile != stdout) {
+		fclose(outputFile);
+	} else {
+		fflush(stdout);
+	}
+
+	if (stats) {
+		auto end = std::chrono::high_resolution_clock::now();
+		auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+		std::cerr << "Microseconds: " << duration << std::endl;
+		std::cerr << "Total value count: " << count << std::endl;
+	}
+	return 0;
+}
@@ -0,0 +1,101 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <jaxup.h>
+
+using namespace jaxup;
+
+int usage(const char* name) {
+	std::cerr << "Expected format: " << name << " inputFile outputFile (--key path | --desc path)... [--threads N] [--memory MB] [--temp-dir dir]" << std::endl;
+	return 1;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 5) {
+		return usage(argv[0]);
+	}
+	auto start = std::chrono::high_resolution_clock::now();
+	size_t threads = 0;
+	size_t memoryMB = 0;
+	const char* tempDirectory = nullptr;
+	std::vector<std::pair<std::string, bool>> keys;
+	for (int arg = 3; arg < argc; ++arg) {
+		if (std::strcmp(argv[arg], "--key") == 0 && arg + 1 < argc) {
+			keys.emplace_back(argv[++arg], false);
+		} else if (std::strcmp(argv[arg], "--desc") == 0 && arg + 1 < argc) {
+			keys.emplace_back(argv[++arg], true);
+		} else if (std::strcmp(argv[arg], "--threads") == 0 && arg + 1 < argc) {
+			threads = std::strtoul(argv[++arg], nullptr, 10);
+		} else if (std::strcmp(argv[arg], "--memory") == 0 && arg + 1 < argc) {
+			memoryMB = std::strtoul(argv[++arg], nullptr, 10);
+		} else if (std::strcmp(argv[arg], "--temp-dir") == 0 && arg + 1 < argc) {
+			tempDirectory = argv[++arg];
+		} else {
+			return usage(argv[0]);
+		}
+	}
+	FILE* inputFile = fopen(argv[1], "rb");
+	if (inputFile == nullptr) {
+		std::cerr << "Unable to open " << argv[1] << std::endl;
+		return 1;
+	}
+	FILE* outputFile = fopen(argv[2], "wb");
+	if (outputFile == nullptr) {
+		std::cerr << "Unable to open " << argv[2] << std::endl;
+		return 1;
+	}
+	uint64_t numRecords = 0;
+	try {
+		JsonThreadPool pool(threads);
+		JsonSorter sorter(pool);
+		for (const auto& key : keys) {
+			sorter.addKey(key.first, key.second);
+		}
+		if (memoryMB > 0) {
+			sorter.setMemoryLimit(memoryMB << 20);
+		}
+		if (tempDirectory != nullptr) {
+			sorter.setTempDirectory(tempDirectory);
+		}
+		numRecords = sorter.sort(inputFile, outputFile);
+	} catch (const JsonException& e) {
+		std::cerr << "Failed to sort file: " << e.what() << std::endl;
+		return 1;
+	}
+	fclose(inputFile);
+	if (fclose(outputFile) != 0) {
+		std::cerr << "Failed to write " << argv[2] << std::endl;
+		return 1;
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+	std::cerr << "Microseconds: " << duration << std::endl;
+	std::cerr << "Total record count: " << numRecords << std::endl;
+	return 0;
+}
@@ -0,0 +1,113 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <jaxup.h>
+
+using namespace jaxup;
+
+int usage(const char* name) {
+	std::cerr << "Expected format: " << name << " inputFile [outputFile] [--ndjson] [--threads N] [--max-paths N] [--prettify] [--stats]" << std::endl;
+	return 1;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		return usage(argv[0]);
+	}
+	const char* outputPath = nullptr;
+	bool ndjson = false;
+	bool prettify = false;
+	bool stats = false;
+	size_t threads = 0;
+	JsonStatistics statistics;
+	for (int arg = 2; arg < argc; ++arg) {
+		if (std::strcmp(argv[arg], "--ndjson") == 0) {
+			ndjson = true;
+		} else if (std::strcmp(argv[arg], "--threads") == 0 && arg + 1 < argc) {
+			threads = std::strtoul(argv[++arg], nullptr, 10);
+		} else if (std::strcmp(argv[arg], "--max-paths") == 0 && arg + 1 < argc) {
+			statistics.setMaxPaths(std::strtoul(argv[++arg], nullptr, 10));
+		} else if (std::strcmp(argv[arg], "--prettify") == 0) {
+			prettify = true;
+		} else if (std::strcmp(argv[arg], "--stats") == 0) {
+			stats = true;
+		} else if (outputPath == nullptr && argv[arg][0] != '-') {
+			outputPath = argv[arg];
+		} else {
+			return usage(argv[0]);
+		}
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	FILE* inputFile = fopen(argv[1], "rb");
+	if (inputFile == nullptr) {
+		std::cerr << "Unable to open " << argv[1] << std::endl;
+		return 1;
+	}
+	FILE* outputFile = stdout;
+	if (outputPath != nullptr) {
+		outputFile = fopen(outputPath, "wb");
+		if (outputFile == nullptr) {
+			std::cerr << "Unable to open " << outputPath << std::endl;
+			return 1;
+		}
+	}
+	try {
+		if (ndjson) {
+			JsonThreadPool pool(threads);
+			statistics.collect(inputFile, pool);
+		} else {
+			JsonPooledFactory factory;
+			auto parser = factory.createJsonParser(inputFile);
+			statistics.collect(*parser);
+		}
+		JsonPooledFactory factory;
+		auto generator = factory.createJsonGenerator(outputFile, prettify);
+		statistics.write(*generator);
+		generator->flush();
+		fputc('\n', outputFile);
+	} catch (const JsonException& e) {
+		std::cerr << "Failed to collect statistics: " << e.what() << std::endl;
+		return 1;
+	}
+	fclose(inputFile);
+	if (outputFile != stdout) {
+		fclose(outputFile);
+	} else {
+		fflush(stdout);
+	}
+
+	if (stats) {
+		auto end = std::chrono::high_resolution_clock::now();
+		auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+		std::cerr << "Microseconds: " << duration << std::endl;
+		std::cerr << "Total record count: " << statistics.numRecords() << std::endl;
+	}
+	return 0;
+}
@@ -0,0 +1,1230 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017-2025 Kyle Hawk
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+#define JAXUP_USE_NODE_RECYCLER
+#include <jaxup.h>
+
+#include "batch.h"
+
+using namespace jaxup;
+
+static std::string toString(const JsonNode& node) {
+	std::string output;
+	{
+		JsonGenerator<std::string> generator(output, false);
+		node.write(generator);
+	}
+	return output;
+}
+
+static std::string buildDocument(bool ndjson) {
+	std::stringstream ss;
+	if (!ndjson) {
+		ss << "[ ";
+	}
+	for (int i = 0; i < 5000; ++i) {
+		if (!ndjson && i > 0) {
+			ss << ",\n";
+		}
+		switch (i % 4) {
+		case 0:
+			ss << "{\"id\": " << i << ", \"text\": \"brackets ]}[{ and \\\"quotes\\\"\", \"nested\": [[" << i << "], {}]}";
+			break;
+		case 1:
+			ss << "\"string " << i << "\"";
+			break;
+		case 2:
+			ss << i << ".5";
+			break;
+		default:
+			ss << "[true, false, null]";
+		}
+		if (ndjson) {
+			ss << "\n";
+		}
+	}
+	if (!ndjson) {
+		ss << " ]";
+	}
+	return ss.str();
+}
+
+static std::string copyTokens(std::string document) {
+	JsonParser<std::string> parser(document);
+	std::string output;
+	{
+		JsonGenerator<std::string> generator(output, false);
+		while (parser.nextToken() != JsonToken::NOT_AVAILABLE) {
+			generator.copyCurrentEvent(parser);
+		}
+	}
+	return output;
+}
+
+int testLogSink() {
+	const int numThreads = 4;
+	const int numRecords = 1000;
+	FILE* file = std::tmpfile();
+	if (file == nullptr) {
+		std::cout << "Unable to create a temporary file for logging" << std::endl;
+		return 1;
+	}
+	int errors = 0;
+	{
+		JsonLogSink sink(file);
+		std::vector<std::thread> threads;
+		for (int t = 0; t < numThreads; ++t) {
+			threads.emplace_back([&sink, t]() {
+				for (int i = 0; i < numRecords; ++i) {
+					if (i % 100 == 0) {
+						// Never finished, so dropped
+						auto partial = sink.startRecord();
+						partial->startObject();
+						partial->writeField("partial", true);
+					}
+					auto record = sink.startRecord();
+					record->startObject();
+					record->writeField("thread", t);
+					record->writeField("seq", i);
+					// Now and then bigger than the buffers the sink keeps
+					record->writeField("text", std::string(i % 250 == 0 ? 70000 : 10, 'x'));
+					record->endObject();
+				}
+			});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		sink.flush();
+		if (sink.hasFailed()) {
+			std::cout << "Log sink failed to write" << std::endl;
+			++errors;
+		}
+	}
+	rewind(file);
+	std::string contents;
+	char chunk[65536];
+	size_t count;
+	while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+		contents.append(chunk, count);
+	}
+	fclose(file);
+	// Every record once, each thread's in the order they were written
+	std::vector<int> next(numThreads, 0);
+	int lines = 0;
+	JsonParser<std::string> parser(contents);
+	JsonNode record;
+	parser.nextToken();
+	while (parser.currentToken() != JsonToken::NOT_AVAILABLE) {
+		record.read(parser);
+		int64_t t = record["thread"].asInteger(-1);
+		if (t < 0 || t >= numThreads || record["seq"].asInteger(-1) != next[t]) {
+			std::cout << "Unexpected log record from thread " << t << ": " << toString(record["seq"]) << std::endl;
+			return errors + 1;
+		}
+		++next[t];
+		++lines;
+	}
+	if (lines != numThreads * numRecords || std::count(contents.begin(), contents.end(), '\n') != lines) {
+		std::cout << "Log sink wrote " << lines << " records" << std::endl;
+		++errors;
+	}
+	return errors;
+}
+
+int testObjectPool() {
+	int errors = 0;
+	std::string first = "{\"a\": [1, 2, 3]}";
+	std::string second = "[\"b\"]";
+	const JsonParser<std::string>* released;
+	{
+		auto parser = acquireJsonParser(first);
+		// Left part way through the document
+		parser->nextToken();
+		parser->nextToken();
+		released = parser.get();
+	}
+	{
+		auto parser = acquireJsonParser(second);
+		JsonNode node;
+		node.read(*parser);
+		if (parser.get() != released || toString(node) != "[\"b\"]") {
+			std::cout << "Pooled parser was not reused from the start of its new input" << std::endl;
+			++errors;
+		}
+	}
+	std::string firstOutput;
+	std::string secondOutput;
+	const JsonGenerator<std::string>* releasedGenerator;
+	{
+		auto generator = acquireJsonGenerator(firstOutput, true);
+		generator->startArray();
+		generator->write(1);
+		releasedGenerator = generator.get();
+	}
+	{
+		auto generator = acquireJsonGenerator(secondOutput, false);
+		generator->startObject();
+		generator->writeField("c", 2);
+		generator->endObject();
+		if (generator.get() != releasedGenerator) {
+			std::cout << "Pooled generator was not reused" << std::endl;
+			++errors;
+		}
+	}
+	if (firstOutput.empty() || secondOutput != "{\"c\":2}") {
+		std::cout << "Pooled generator output is wrong: " << secondOutput << std::endl;
+		++errors;
+	}
+	// Past the thread's own list, released parsers go to the shared one
+	std::vector<const JsonParser<std::string>*> overflow;
+	{
+		std::vector<JsonPoolHandle<JsonParser<std::string>>> handles;
+		for (size_t i = 0; i < JsonObjectPool<JsonParser<std::string>>::maxThreadLocal + 2; ++i) {
+			handles.push_back(acquireJsonParser(first));
+		}
+		for (size_t i = 0; i < handles.size(); ++i) {
+			if (i >= JsonObjectPool<JsonParser<std::string>>::maxThreadLocal) {
+				overflow.push_back(handles[i].get());
+			}
+			handles[i].release();
+		}
+	}
+	const JsonParser<std::string>* fromOtherThread = nullptr;
+	std::thread other([&]() {
+		auto parser = acquireJsonParser(second);
+		fromOtherThread = parser.get();
+	});
+	other.join();
+	if (std::find(overflow.begin(), overflow.end(), fromOtherThread) == overflow.end()) {
+		std::cout << "Another thread did not reuse a parser from the shared pool" << std::endl;
+		++errors;
+	}
+	return errors;
+}
+
+int testParallelWriter() {
+	std::string document = buildDocument(false);
+	JsonParser<std::string> parser(document);
+	JsonNode records;
+	records.read(parser);
+	JsonNode fields;
+	for (size_t i = 0; i < records.size(); i += 7) {
+		fields["field " + std::to_string(i)] = records[i];
+	}
+	int errors = 0;
+	JsonThreadPool threads(3);
+	for (const JsonNode* node : {&records, &fields}) {
+		for (bool prettyPrint : {false, true}) {
+			std::string expected;
+			std::string actual;
+			{
+				JsonGenerator<std::string> generator(expected, prettyPrint);
+				node->write(generator);
+				JsonGenerator<std::string> parallelGenerator(actual, prettyPrint);
+				JsonParallelWriter(threads).setMinParallelSize(2).setChunkSize(5).setMaxChunksInFlight(4).write(*node, parallelGenerator);
+			}
+			if (actual != expected) {
+				std::cout << "Parallel writer output does not match JsonNode::write" << (prettyPrint ? " when pretty printing" : "") << std::endl;
+				++errors;
+			}
+		}
+	}
+	return errors;
+}
+
+int testPipeline() {
+	std::string document = buildDocument(true);
+	const std::string expected = copyTokens(document);
+	int errors = 0;
+	// Small batches and few of them so that every stage has to wait
+	std::string actual;
+	size_t numTokens;
+	{
+		JsonParser<std::string> parser(document);
+		JsonGenerator<std::string> generator(actual, false);
+		numTokens = runJsonPipeline(parser, generator, nullptr, 7, 2);
+	}
+	if (actual != expected || numTokens != 26250) {
+		std::cout << "Pipelined copy does not match, with " << numTokens << " tokens" << std::endl;
+		++errors;
+	}
+	actual.clear();
+	size_t batches = 0;
+	try {
+		JsonParser<std::string> parser(document);
+		JsonGenerator<std::string> generator(actual, false);
+		runJsonPipeline(parser, generator, [&batches](JsonTokenBatch&) {
+			if (++batches == 100) {
+				throw JsonException("Stop");
+			}
+		}, 7, 2);
+		std::cout << "Pipeline should pass on an exception from the transform" << std::endl;
+		++errors;
+	} catch (const JsonException& e) {
+		if (std::string(e.what()) != "Stop") {
+			std::cout << "Unexpected pipeline exception: " << e.what() << std::endl;
+			++errors;
+		}
+	}
+	return errors;
+}
+
+int testBatchNames() {
+	// Neither path exists, so both are taken as files named directly
+	const char* argv[] = {"tool", "--batch", "out", "--threads", "2", "first/f.json", "second/f.json"};
+	BatchOptions options;
+	int errors = 0;
+	if (parseBatchArgs(7, const_cast<char**>(argv), 2, true, options)) {
+		std::cout << "Inputs with the same output name were accepted" << std::endl;
+		++errors;
+	}
+	options = BatchOptions();
+	if (!parseBatchArgs(6, const_cast<char**>(argv), 2, true, options) || options.outputNames.size() != 1 || options.outputNames[0] != "f.json") {
+		std::cout << "Batch output name is wrong" << std::endl;
+		++errors;
+	}
+	options = BatchOptions();
+	options.inputs = {"in/a/f.json", "in/b/f.json"};
+	options.outputNames = {"a/f.json", "b/f.json"};
+	if (!checkOutputNames(options)) {
+		std::cout << "Files in different subdirectories should have different outputs" << std::endl;
+		++errors;
+	}
+	return errors;
+}
+
+int testIndex(bool ndjson) {
+	int numErrors = 0;
+	std::stringstream ss(buildDocument(ndjson));
+	JsonParser<std::istream> parser(ss);
+
+	std::vector<std::string> expected;
+	parser.nextToken();
+	if (!ndjson) {
+		parser.nextToken();
+	}
+	while (parser.currentToken() != JsonToken::NOT_AVAILABLE && parser.currentToken() != JsonToken::END_ARRAY) {
+		JsonNode node;
+		node.read(parser);
+		expected.push_back(toString(node));
+	}
+
+	parser.seek(0);
+	JsonIndex index;
+	index.build(parser, ndjson ? JsonIndexLayout::SEQUENCE : JsonIndexLayout::ARRAY);
+	if (index.size() != expected.size()) {
+		std::cout << "Index has " << index.size() << " elements, expected " << expected.size() << std::endl;
+		return 1;
+	}
+	for (size_t i = expected.size(); i-- > 0;) {
+		JsonNode node;
+		index.read(parser, i, node);
+		std::string actual = toString(node);
+		if (actual != expected[i]) {
+			std::cout << "Element " << i << " does not match.  Expected: " << expected[i] << ", got: " << actual << std::endl;
+			++numErrors;
+		}
+		std::string raw = ss.str().substr(index[i].offset, index[i].length);
+		std::stringstream rawStream(raw);
+		JsonParser<std::istream> rawParser(rawStream);
+		JsonNode rawNode;
+		rawNode.read(rawParser);
+		if (toString(rawNode) != expected[i]) {
+			std::cout << "Element " << i << " has the wrong extent: " << raw << std::endl;
+			++numErrors;
+		}
+	}
+	return numErrors;
+}
+
+static std::string describeToken(JsonParser<std::istream>& parser) {
+	JsonToken token = parser.currentToken();
+	std::string description = getTokenAsString(token);
+	switch (token) {
+	case JsonToken::FIELD_NAME:
+		return description + " " + parser.getCurrentName();
+	case JsonToken::VALUE_STRING:
+		return description + " " + parser.getText();
+	case JsonToken::VALUE_NUMBER_INT:
+	case JsonToken::VALUE_NUMBER_FLOAT:
+		return description + " " + std::to_string(parser.getDoubleValue());
+	default:
+		return description;
+	}
+}
+
+int testCheckpoint() {
+	int numErrors = 0;
+	std::string document = buildDocument(false);
+	std::stringstream ss(document);
+	JsonParser<std::istream> parser(ss);
+	std::vector<std::string> expected;
+	while (parser.nextToken() != JsonToken::NOT_AVAILABLE) {
+		expected.push_back(describeToken(parser));
+	}
+
+	for (size_t stop = 0; stop < expected.size(); stop += 997) {
+		ss.clear();
+		parser.seek(0);
+		for (size_t i = 0; i <= stop; ++i) {
+			parser.nextToken();
+		}
+		std::string saved;
+		{
+			JsonGenerator<std::string> generator(saved, false);
+			writeParserState(generator, parser.checkpoint());
+		}
+
+		std::stringstream savedStream(saved);
+		JsonParser<std::istream> stateParser(savedStream);
+		JsonParserState state;
+		readParserState(stateParser, state);
+
+		std::stringstream resumedStream(document);
+		JsonParser<std::istream> resumed(resumedStream);
+		resumed.restore(state);
+		if (describeToken(resumed) != expected[stop]) {
+			std::cout << "Restored token " << stop << " does not match.  Expected: " << expected[stop] << ", got: " << describeToken(resumed) << std::endl;
+			++numErrors;
+		}
+		for (size_t i = stop + 1; i < expected.size(); ++i) {
+			resumed.nextToken();
+			if (describeToken(resumed) != expected[i]) {
+				std::cout << "Resumed token " << i << " does not match.  Expected: " << expected[i] << ", got: " << describeToken(resumed) << std::endl;
+				++numErrors;
+				break;
+			}
+		}
+		if (resumed.nextToken() != JsonToken::NOT_AVAILABLE) {
+			std::cout << "Resumed parser did not end with the stream" << std::endl;
+			++numErrors;
+		}
+	}
+	return numErrors;
+}
+
+static std::string filterDocument(JsonFilter& filter, const std::string& document) {
+	std::stringstream ss(document);
+	JsonParser<std::istream> parser(ss);
+	std::string output;
+	{
+		JsonGenerator<std::string> generator(output, false);
+		generator.setRootValueSeparator("\n");
+		filter.copy(parser, generator);
+	}
+	return output;
+}
+
+int testFilter() {
+	int numErrors = 0;
+	const std::string document = "{\"user\": {\"name\": \"a\", \"password\": \"x\", \"address\": {\"city\": \"c\", \"zip\": 1}},"
+		" \"items\": [{\"id\": 1, \"secret\": {\"password\": \"]}\"}, \"tags\": [1, 2]}, {\"id\": 2}], \"count\": 5}\n"
+		"[1, {\"password\": 2}]";
+	struct {
+		const char* include;
+		const char* exclude;
+		const char* expected;
+	} cases[] = {
+		{nullptr, "..password", "{\"user\":{\"name\":\"a\",\"address\":{\"city\":\"c\",\"zip\":1}},\"items\":[{\"id\":1,\"secret\":{},\"tags\":[1,2]},{\"id\":2}],\"count\":5}\n[1,{}]"},
+		{"items[*].id", nullptr, "{\"items\":[{\"id\":1},{\"id\":2}]}\n[]"},
+		{"user.address", "user.address.zip", "{\"user\":{\"address\":{\"city\":\"c\"}}}\n[]"},
+		{"[1]", nullptr, "{}\n[{\"password\":2}]"},
+		{"", "items", "{\"user\":{\"name\":\"a\",\"password\":\"x\",\"address\":{\"city\":\"c\",\"zip\":1}},\"count\":5}\n[1,{\"password\":2}]"},
+		{nullptr, "user", "{\"items\":[{\"id\":1,\"secret\":{\"password\":\"]}\"},\"tags\":[1,2]},{\"id\":2}],\"count\":5}\n[1,{\"password\":2}]"}
+	};
+	for (const auto& c : cases) {
+		JsonFilter filter;
+		if (c.include != nullptr) {
+			filter.include(c.include);
+		}
+		if (c.exclude != nullptr) {
+			filter.exclude(c.exclude);
+		}
+		std::string actual = filterDocument(filter, document);
+		if (actual != c.expected) {
+			std::cout << "Filter output does not match.  Expected: " << c.expected << ", got: " << actual << std::endl;
+			++numErrors;
+		}
+	}
+	return numErrors;
+}
+
+int testQuery() {
+	int numErrors = 0;
+	std::string document = "{\"store\": {\"books\": [{\"title\": \"A\", \"price\": 5}, {\"title\": \"B\", \"price\": 12.5, \"author\": {\"name\": \"Z\"}},"
+		" {\"title\": \"C\", \"price\": 20}], \"name\": \"shop\"}}\n[1, 2, 3, 4]";
+	struct {
+		const char* query;
+		const char* expected;
+	} cases[] = {
+		{".store.books[].title", "\"A\"\n\"B\"\n\"C\""},
+		{".store.books[1:][] | .price", "12.5\n20"},
+		{".store.missing.title", "null"},
+		{".[1:3], .[-1]", "[2,3]\n4"},
+		{".store.books[] | select(.price > 10 and .title != \"C\") | {title, who: .author.name}", "{\"title\":\"B\",\"who\":\"Z\"}"},
+		{"[.store.books[] | .price < 10] | length", "3\n0"},
+		{".store | keys", "[\"books\",\"name\"]"}
+	};
+	for (const auto& c : cases) {
+		JsonParser<std::string> parser(document);
+		std::string actual;
+		{
+			JsonGenerator<std::string> generator(actual, false);
+			generator.setRootValueSeparator("\n");
+			JsonQuery(c.query).run(parser, generator);
+		}
+		if (actual != c.expected) {
+			std::cout << "Query " << c.query << " output does not match.  Expected: " << c.expected << ", got: " << actual << std::endl;
+			++numErrors;
+		}
+	}
+	return numErrors;
+}
+
+int testSort() {
+	const std::string input = "{\"t\": 3, \"id\": 1}\n{\"id\": 2}\n{\"t\": 1, \"id\": 3}\n{\"t\": \"x\", \"id\": 4}\n{\"t\": 1, \"id\": 5}\n";
+	const std::string expected = "{\"id\": 2}\n{\"t\": 1, \"id\": 5}\n{\"t\": 1, \"id\": 3}\n{\"t\": 3, \"id\": 1}\n{\"t\": \"x\", \"id\": 4}\n";
+	FILE* inputFile = std::tmpfile();
+	FILE* outputFile = std::tmpfile();
+	if (inputFile == nullptr || outputFile == nullptr) {
+		std::cout << "Unable to create temporary files for sorting" << std::endl;
+		return 1;
+	}
+	fwrite(input.data(), 1, input.size(), inputFile);
+	rewind(inputFile);
+	JsonThreadPool pool(2);
+	JsonSorter sorter(pool);
+	sorter.addKey("t").addKey(".id", true);
+	uint64_t count = sorter.sort(inputFile, outputFile);
+	rewind(outputFile);
+	std::string actual(input.size() + 16, '\0');
+	actual.resize(fread(&actual[0], 1, actual.size(), outputFile));
+	fclose(inputFile);
+	fclose(outputFile);
+	if (count != 5 || actual != expected) {
+		std::cout << "Sorted output does not match.  Expected: " << expected << "got: " << actual << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+int testAggregate() {
+	// The skipped fields exercise JsonParser::skipNextValue
+	std::string document = "{\"k\": \"a\", \"s\": \"x\\\"}\", \"n\": -1.5e3, \"t\": true, \"z\": null, \"o\": {\"v\": [1]}, \"v\": 2}\n"
+		"{\"o\": [{}, \"]\"], \"k\": \"b\", \"v\": 1.5}\n"
+		"{\"k\": \"a\", \"v\": 5, \"f\": false}\n"
+		"{\"v\": \"text\"}";
+	const std::string expected = "{\"k\":null,\"count\":1,\"sum(v)\":0,\"max(v)\":null,\"distinct(v)\":1}"
+		"{\"k\":\"a\",\"count\":2,\"sum(v)\":7,\"max(v)\":5,\"distinct(v)\":2}"
+		"{\"k\":\"b\",\"count\":1,\"sum(v)\":1.5,\"max(v)\":1.5,\"distinct(v)\":1}";
+	JsonAggregator aggregator;
+	aggregator.groupBy("k").add(JsonAggregateFunction::COUNT).add(JsonAggregateFunction::SUM, "v")
+		.add(JsonAggregateFunction::MAX, "v").add(JsonAggregateFunction::DISTINCT, "v");
+	JsonParser<std::string> parser(document);
+	uint64_t count = aggregator.aggregate(parser);
+	std::string actual;
+	{
+		JsonGenerator<std::string> generator(actual, false);
+		aggregator.write(generator);
+	}
+	if (count != 4 || actual != expected) {
+		std::cout << "Aggregate output does not match.  Expected: " << expected << ", got: " << actual << std::endl;
+		return 1;
+	}
+	// Paths inside a container that is grouped on
+	std::string nested = "{\"g\": {\"v\": 2}} {\"g\": {\"v\": 3}} {\"g\": {\"v\": 2}}";
+	const std::string expectedNested = "{\"g\":{\"v\":2},\"count(g)\":2,\"sum(g.v)\":4}{\"g\":{\"v\":3},\"count(g)\":1,\"sum(g.v)\":3}";
+	JsonAggregator nestedAggregator;
+	nestedAggregator.groupBy("g").add(JsonAggregateFunction::COUNT, "g").add(JsonAggregateFunction::SUM, "g.v");
+	JsonParser<std::string> nestedParser(nested);
+	nestedAggregator.aggregate(nestedParser);
+	actual.clear();
+	{
+		JsonGenerator<std::string> generator(actual, false);
+		nestedAggregator.write(generator);
+	}
+	if (actual != expectedNested) {
+		std::cout << "Nested aggregate output does not match.  Expected: " << expectedNested << ", got: " << actual << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+int testStatistics() {
+	std::string first = "{\"a\": 1, \"b\": \"xy\", \"c\": [1, 2.5]}";
+	std::string second = "{\"b\": null, \"a\": -300, \"d e\": {}}";
+	JsonStatistics whole;
+	std::string document = first + "\n" + second;
+	JsonParser<std::string> parser(document);
+	whole.collect(parser);
+	JsonStatistics merged;
+	JsonStatistics partial;
+	JsonParser<std::string> firstParser(first);
+	JsonParser<std::string> secondParser(second);
+	merged.collect(firstParser);
+	partial.collect(secondParser);
+	merged.merge(partial);
+	std::string expected;
+	std::string actual;
+	{
+		JsonGenerator<std::string> generator(expected, false);
+		whole.write(generator);
+		JsonGenerator<std::string> mergedGenerator(actual, false);
+		merged.write(mergedGenerator);
+	}
+	if (actual != expected) {
+		std::cout << "Merged statistics do not match.  Expected: " << expected << ", got: " << actual << std::endl;
+		return 1;
+	}
+	const char* fragments[] = {
+		"\"records\":2,",
+		"\".b\":{\"count\":2,\"presence\":1,\"nullRate\":0.5,",
+		"\"magnitudeHistogram\":{\"-1e3..-1e2\":1,\"1e0..1e1\":1}",
+		"\".c[*]\":{\"count\":2,\"nullRate\":0,\"types\":{\"integer\":1,\"float\":1}",
+		"\"[\\\"d e\\\"]\":{\"count\":1,\"presence\":0.5,",
+		"\"keyOrders\":2,\"keySets\":2,"
+	};
+	int errors = 0;
+	for (const char* fragment : fragments) {
+		if (expected.find(fragment) == std::string::npos) {
+			std::cout << "Statistics are missing " << fragment << " in " << expected << std::endl;
+			++errors;
+		}
+	}
+	return errors;
+}
+
+int testCsv() {
+	std::string document = "{\"a\": 1, \"b\": \"x,\\\"y\\\"\", \"c\": [1, 2.5], \"d\": {\"e\": \"two\\nlines\"}}\n"
+		"{\"b\": null, \"a\": -3.5, \"z\": {\"q\": 1}}";
+	const std::string expected = ".a,b,.c,.d.e,.c[1]\n"
+		"1,\"x,\"\"y\"\"\",\"[1,2.5]\",\"two\nlines\",2.5\n"
+		"-3.5,,,,\n";
+	JsonCsvWriter writer;
+	writer.addColumn(".a").addColumn(".b", "b").addColumn(".c").addColumn(".d.e").addColumn(".c[1]");
+	std::string actual;
+	writer.writeHeader(actual);
+	JsonParser<std::string> parser(document);
+	uint64_t count = writer.convert(parser, actual);
+	if (count != 2 || actual != expected) {
+		std::cout << "CSV output does not match.  Expected: " << expected << ", got: " << actual << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+int testCanonical() {
+	// The example from RFC 8785, plus keys that sort differently in UTF-16
+	std::string document = "{\"numbers\": [333333333.33333329, 1E30, 4.50, 2e-3, 0.000000000000000000000000001],"
+		" \"string\": \"\\u20ac$\\u000F\\u000aA'\\u0042\\u0022\\u005c\\\\\\\"\\/\", \"literals\": [null, true, false],"
+		" \"\\ufb33\": -0.0, \"\\ud83d\\ude00\": 1e21}";
+	const std::string expected = "{\"literals\":[null,true,false],\"numbers\":[333333333.3333333,1e+30,4.5,0.002,1e-27],"
+		"\"string\":\"\xE2\x82\xAC$\\u000f\\nA'B\\\"\\\\\\\\\\\"/\",\"\xF0\x9F\x98\x80\":1e+21,\"\xEF\xAC\xB3\":0}";
+	JsonParser<std::string> parser(document);
+	JsonNode node;
+	node.read(parser);
+	int errors = 0;
+	std::string actual = toCanonicalJson(node);
+	if (actual != expected) {
+		std::cout << "Canonical output does not match.  Expected: " << expected << ", got: " << actual << std::endl;
+		++errors;
+	}
+	JsonSha256 hash;
+	hash.update(expected.data(), expected.size());
+	const std::string expectedHash = hash.hexDigest();
+	if (getCanonicalSha256(node) != expectedHash) {
+		std::cout << "Canonical hash does not match" << std::endl;
+		++errors;
+	}
+	hash.update("abc", 3);
+	if (hash.hexDigest() != "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad") {
+		std::cout << "SHA-256 of abc does not match" << std::endl;
+		++errors;
+	}
+	std::string unsorted;
+	JsonGenerator<std::string> generator(unsorted, false);
+	generator.setCanonical(true);
+	generator.startObject();
+	generator.writeField("b", 1);
+	try {
+		generator.writeField("a", 2);
+		std::cout << "Out of order canonical key was accepted" << std::endl;
+		++errors;
+	} catch (const JsonException&) {
+	}
+	JsonNode wide;
+	for (int i = 0; i < 40; ++i) {
+		wide[std::to_string((i * 7) % 40)] = node;
+	}
+	std::string parallel;
+	{
+		JsonThreadPool threads(2);
+		JsonParallelWriter writer(threads);
+		writer.setMinParallelSize(4).setChunkSize(3);
+		JsonGenerator<std::string> parallelGenerator(parallel, false);
+		parallelGenerator.setCanonical(true);
+		writer.write(wide, parallelGenerator);
+	}
+	if (parallel != toCanonicalJson(wide)) {
+		std::cout << "Parallel canonical output does not match" << std::endl;
+		++errors;
+	}
+	// Pooled generators come back without the last user's settings
+	std::string pooled;
+	{
+		auto canonicalGenerator = acquireJsonGenerator(pooled, false);
+		canonicalGenerator->setCanonical(true);
+		canonicalGenerator->setRootValueSeparator("\n");
+	}
+	pooled.clear();
+	{
+		auto plainGenerator = acquireJsonGenerator(pooled, false);
+		plainGenerator->startObject();
+		plainGenerator->writeField("b", 1);
+		plainGenerator->writeField("a", 2);
+		plainGenerator->endObject();
+		plainGenerator->write(3);
+	}
+	if (pooled != "{\"b\":1,\"a\":2}3") {
+		std::cout << "Pooled generator kept its settings: " << pooled << std::endl;
+		++errors;
+	}
+	return errors;
+}
+
+int testPatch() {
+	std::string fromText = "{\"a\": [1, 2, 3, 4], \"b\": {\"c\": 1.0, \"d/e\": \"x\"}, \"f\": true}";
+	std::string toText = "{\"b\": {\"c\": 1, \"d/e\": \"y\"}, \"a\": [1, 3, 4, 5], \"g\": null}";
+	const std::string expected = "[{\"op\":\"remove\",\"path\":\"/a/1\"},{\"op\":\"add\",\"path\":\"/a/3\",\"value\":5},"
+		"{\"op\":\"replace\",\"path\":\"/b/d~1e\",\"value\":\"y\"},{\"op\":\"remove\",\"path\":\"/f\"},"
+		"{\"op\":\"add\",\"path\":\"/g\",\"value\":null}]";
+	JsonParser<std::string> fromParser(fromText);
+	JsonParser<std::string> toParser(toText);
+	JsonNode from;
+	JsonNode to;
+	from.read(fromParser);
+	to.read(toParser);
+	JsonNode patch = diff(from, to);
+	std::string actual;
+	{
+		JsonGenerator<std::string> generator(actual, false);
+		patch.write(generator);
+	}
+	int errors = 0;
+	if (actual != expected) {
+		std::cout << "Patch does not match.  Expected: " << expected << ", got: " << actual << std::endl;
+		++errors;
+	}
+	applyPatch(from, patch);
+	if (from != to) {
+		std::cout << "Applying the patch did not produce the target" << std::endl;
+		++errors;
+	}
+	std::string moveText = "[{\"op\": \"move\", \"from\": \"/a/0\", \"path\": \"/b/first\"}, {\"op\": \"test\", \"path\": \"/b/first\", \"value\": 1}]";
+	JsonParser<std::string> moveParser(moveText);
+	JsonNode move;
+	move.read(moveParser);
+	applyPatch(from, move);
+	if (from["a"].size() != 3 || from["b"].getInteger("first") != 1) {
+		std::cout << "Move operation was not applied" << std::endl;
+		++errors;
+	}
+	try {
+		applyPatch(from, move);
+		std::cout << "Failed test operation was not reported" << std::endl;
+		++errors;
+	} catch (const JsonException&) {
+	}
+	return errors;
+}
+
+int testStreamingPatch() {
+	std::string document = "{\"a\": {\"b\": 1, \"c\": [1, 2]}, \"d\": [{\"e\": 1}, {\"e\": 2}], \"f\": \"x\"}\n{\"a\": 2}";
+	std::string mergeText = "{\"a\": {\"b\": null, \"g\": {\"h\": null, \"i\": 1}}, \"f\": \"y\"}";
+	std::string patchText = "[{\"op\": \"replace\", \"path\": \"/d/1/e\", \"value\": 3}, {\"op\": \"add\", \"path\": \"/d/0\", \"value\": 0},"
+		" {\"op\": \"remove\", \"path\": \"/f\"}, {\"op\": \"add\", \"path\": \"/d/-\", \"value\": 4}]";
+	const std::string expectedMerge = "{\"a\":{\"c\":[1, 2],\"g\":{\"i\":1}},\"d\":[{\"e\": 1}, {\"e\": 2}],\"f\":\"y\"}"
+		"{\"a\":{\"g\":{\"i\":1}},\"f\":\"y\"}";
+	const std::string expectedPatch = "{\"a\":{\"b\": 1, \"c\": [1, 2]},\"d\":[0,{\"e\": 1},{\"e\":3},4]}";
+	JsonParser<std::string> mergeParser(mergeText);
+	JsonParser<std::string> patchParser(patchText);
+	JsonNode merge;
+	JsonNode patch;
+	merge.read(mergeParser);
+	patch.read(patchParser);
+	int errors = 0;
+	std::string actual;
+	{
+		JsonParser<std::string> parser(document);
+		JsonGenerator<std::string> generator(actual, false);
+		JsonStreamingPatcher::fromMergePatch(merge).apply(parser, generator);
+	}
+	if (actual != expectedMerge) {
+		std::cout << "Streamed merge patch does not match.  Expected: " << expectedMerge << ", got: " << actual << std::endl;
+		++errors;
+	}
+	actual.clear();
+	{
+		std::string first = document.substr(0, document.find('\n'));
+		JsonParser<std::string> parser(first);
+		JsonGenerator<std::string> generator(actual, false);
+		JsonStreamingPatcher::fromJsonPatch(patch).apply(parser, generator);
+	}
+	if (actual != expectedPatch) {
+		std::cout << "Streamed JSON Patch does not match.  Expected: " << expectedPatch << ", got: " << actual << std::endl;
+		++errors;
+	}
+	actual.clear();
+	try {
+		std::string scalars = "null \"c\" 3 [1, {\"a\": 2}]";
+		JsonParser<std::string> parser(scalars);
+		JsonGenerator<std::string> generator(actual, false);
+		JsonNode empty;
+		empty.makeArray();
+		JsonStreamingPatcher::fromJsonPatch(empty).apply(parser, generator);
+	} catch (const JsonException& e) {
+		actual = e.what();
+	}
+	if (actual != "null\"c\"3[1, {\"a\": 2}]") {
+		std::cout << "Empty JSON Patch should copy values through, got: " << actual << std::endl;
+		++errors;
+	}
+	// Applied in sequence, the remove would see the added element
+	std::string shiftingText = "[{\"op\": \"add\", \"path\": \"/a/1\", \"value\": 9}, {\"op\": \"remove\", \"path\": \"/a/2\"}]";
+	JsonParser<std::string> shiftingParser(shiftingText);
+	JsonNode shifting;
+	shifting.read(shiftingParser);
+	try {
+		JsonStreamingPatcher::fromJsonPatch(shifting);
+		std::cout << "JSON Patch with shifted indices was accepted" << std::endl;
+		++errors;
+	} catch (const JsonException&) {
+	}
+	return errors;
+}
+
+int testHash() {
+	std::string text = "{\"a\": [1, 2.0, {\"b\": null}], \"c\": \"x\"} {\"c\": \"x\", \"a\": [1.0, 2, {\"b\": null}]}";
+	JsonParser<std::string> parser(text);
+	JsonNode first;
+	JsonNode second;
+	first.read(parser);
+	second.read(parser);
+	int errors = 0;
+	if (first != second || first.hash() != second.hash()) {
+		std::cout << "Reordered objects with equal numbers should compare and hash equal" << std::endl;
+		++errors;
+	}
+	JsonNode& inner = second["a"][2];
+	uint64_t before = second.hash();
+	inner["b"] = true;
+	if (first == second || first.hash() == second.hash() || second.hash() == before) {
+		std::cout << "Changing a child through a reference should change the hash" << std::endl;
+		++errors;
+	}
+	JsonNode large;
+	for (int i = 0; i < 100; ++i) {
+		large.append() = i;
+	}
+	large.append().append() = first;
+	JsonHashCache cache;
+	if (cache.hash(large) != large.hash() || cache.hash(large[100]) != large[100].hash() || cache.size() != 1) {
+		std::cout << "Hash cache should hold only the large array, with matching hashes" << std::endl;
+		++errors;
+	}
+	JsonNode changed = large;
+	changed[100][0]["c"] = "y";
+	if (!cache.equal(large, large) || cache.equal(large, changed) || cache.equal(changed, large) || cache.size() != 2) {
+		std::cout << "Hash cache equality is wrong" << std::endl;
+		++errors;
+	}
+	inner["b"] = nullptr;
+	std::unordered_set<JsonNode> set;
+	set.insert(std::move(first));
+	if (set.count(second) != 1) {
+		std::cout << "Equal node was not found in a hash set" << std::endl;
+		++errors;
+	}
+	// Repeated keys have to be matched one for one
+	std::string repeated = "{\"a\": 1, \"a\": 1} {\"a\": 1, \"b\": 2} {\"a\": 1.0, \"a\": 1}";
+	JsonParser<std::string> repeatedParser(repeated);
+	JsonNode twice;
+	JsonNode once;
+	JsonNode again;
+	twice.read(repeatedParser);
+	once.read(repeatedParser);
+	again.read(repeatedParser);
+	if (twice == once || once == twice || twice != again || again.hash() != twice.hash()) {
+		std::cout << "Objects with repeated keys compare wrongly" << std::endl;
+		++errors;
+	}
+	return errors;
+}
+
+int testStringPool() {
+	std::string text = "[{\"country\": \"NZ\", \"note\": \"a long note that should not be pooled\"}, {\"country\": \"NZ\"}, \"US\"]";
+	JsonParser<std::string> parser(text);
+	JsonStringPool pool;
+	pool.setMaxLength(8);
+	JsonNode node;
+	node.read(parser, pool);
+	int errors = 0;
+	if (pool.size() != 2 || &node[0].getString("country") != &node[1].getString("country")) {
+		std::cout << "Repeated strings were not shared through the pool" << std::endl;
+		++errors;
+	}
+	JsonNode copy;
+	copy.copyFrom(node);
+	node[1]["country"] = "AU";
+	if (copy[1].getString("country") != "NZ" || node[0].getString("country") != "NZ" || copy[0].getString("note") != node[0].getString("note")) {
+		std::cout << "Pooled strings were not kept independent of their nodes" << std::endl;
+		++errors;
+	}
+	return errors;
+}
+
+int testRecycler() {
+	std::string text = "{\"id\": 1, \"tags\": [\"a long tag that needs its own buffer\", \"b\"], \"user\": {\"name\": \"u1\"}}\n"
+		"{\"id\": 2, \"tags\": [\"another long tag needing a buffer\", \"c\"], \"user\": {\"name\": \"u2\"}}";
+	JsonParser<std::string> parser(text);
+	JsonNode survivor;
+	int errors = 0;
+	{
+		JsonNodeRecycler recycler;
+		JsonNode node;
+		node.read(parser);
+		node.copyTo(survivor);
+		size_t allocations = recycler.numAllocations();
+		node.read(parser);
+		if (recycler.numAllocations() != allocations || recycler.numRecycled() == 0) {
+			std::cout << "Reading a similar document was not served from the recycler" << std::endl;
+			++errors;
+		}
+		if (node["tags"].size() != 2 || node["tags"][0].asString() != "another long tag needing a buffer") {
+			std::cout << "Recycled document was read incorrectly" << std::endl;
+			++errors;
+		}
+	}
+	if (survivor["user"].getString("name") != "u1" || survivor["tags"][0].asString() != "a long tag that needs its own buffer") {
+		std::cout << "Node did not survive its recycler" << std::endl;
+		++errors;
+	}
+	// An outer recycler ending first leaves the inner one in use
+	std::unique_ptr<JsonNodeRecycler> outer(new JsonNodeRecycler);
+	std::unique_ptr<JsonNodeRecycler> inner(new JsonNodeRecycler);
+	outer.reset();
+	{
+		JsonNode node;
+		node.append() = "a string long enough to need its own buffer";
+	}
+	if (inner->numAllocations() == 0 || inner->getRetainedBytes() == 0) {
+		std::cout << "Inner recycler was not used after the outer one ended" << std::endl;
+		++errors;
+	}
+	inner.reset();
+	JsonNode after;
+	after.append() = "allocated with no recycler at all";
+	return errors;
+}
+
+int testSizeHints() {
+	std::string text = "{\"items\": [{\"tags\": [1, 2, 3], \"id\": 1}, {\"tags\": [], \"id\": 2}], \"other\": [[1], {\"tags\": [4]}]}";
+	JsonParser<std::string> plainParser(text);
+	JsonParser<std::string> hintedParser(text);
+	JsonNode plain;
+	plain.read(plainParser);
+	JsonSizeHints hints;
+	hints.add(".items", 2);
+	hints.add(".items[*].tags", 3);
+	hints.add("..tags", 1);
+	JsonNode hinted;
+	hinted.read(hintedParser, hints);
+	int errors = 0;
+	if (plain != hinted || hinted["items"][0]["tags"].size() != 3 || hinted["other"][1]["tags"][0].asInteger() != 4) {
+		std::cout << "Reading with size hints changed the document" << std::endl;
+		++errors;
+	}
+	try {
+		hinted["items"][0]["id"].reserve(1);
+		std::cout << "Reserving in a scalar was not reported" << std::endl;
+		++errors;
+	} catch (const JsonException&) {
+	}
+	return errors;
+}
+
+static_assert(std::is_nothrow_move_constructible<JsonNode>::value, "Node moves should be noexcept");
+
+int testNodeSemantics() {
+	std::string text = "{\"a\": {\"b\": [3, 1, 2]}, \"c\": \"x\"}";
+	JsonParser<std::string> parser(text);
+	JsonNode node;
+	node.read(parser);
+	int errors = 0;
+	JsonNode copy = node;
+	copy = copy["a"];
+	node = std::move(node["a"]["b"]);
+	if (copy["b"].size() != 3 || node.size() != 3 || node[0].asInteger() != 3) {
+		std::cout << "Assigning a node from one of its own children failed" << std::endl;
+		++errors;
+	}
+	std::vector<JsonNode> values;
+	for (size_t i = 0; i < node.size(); ++i) {
+		values.emplace_back(node[i]);
+	}
+	std::sort(values.begin(), values.end(), [](const JsonNode& lhs, const JsonNode& rhs) {
+		return lhs.asInteger() < rhs.asInteger();
+	});
+	swap(copy, node);
+	copy.emplace(copy[0]);
+	node.emplace("d", 4);
+	node.emplace("d", "e");
+	if (values[0].asInteger() != 1 || values[2].asInteger() != 3 || copy.size() != 4 || copy[3].asInteger() != 3 || node.size() != 2
+			|| node["b"].size() != 3 || node["d"].asString() != "e") {
+		std::cout << "Swapped, sorted or emplaced nodes are wrong" << std::endl;
+		++errors;
+	}
+	return errors;
+}
+
+int testSortKeys() {
+	std::string text = "{\"c\": 1, \"a\": {\"z\": 1, \"y\": 2}, \"b\": [{\"q\": 1, \"p\": 2}]}";
+	JsonParser<std::string> parser(text);
+	JsonNode node;
+	node.read(parser);
+	int errors = 0;
+	node.sortKeys();
+	if (!node.isSorted() || node.getField(0).first != "a" || node.getField(2).first != "c"
+			|| node["a"].getField(0).first != "y" || node["b"][0].getField(0).first != "p") {
+		std::cout << "Keys were not sorted recursively" << std::endl;
+		++errors;
+	}
+	node["bb"] = 2;
+	node.remove("a");
+	if (!node.isSorted() || node.getField(1).first != "bb" || node["c"].asInteger() != 1 || node.find("a") != nullptr) {
+		std::cout << "Sorted object lookups or inserts are wrong" << std::endl;
+		++errors;
+	}
+	node.append("aa");
+	if (node.isSorted() || node.find("aa") == nullptr) {
+		std::cout << "Appending out of order should clear the sorted flag" << std::endl;
+		++errors;
+	}
+	node.sortKeys(false);
+	JsonParser<std::string> reparser(text);
+	JsonNode unsorted = node;
+	unsorted.read(reparser);
+	if (!node.isSorted() || node.getField(0).first != "aa" || unsorted.isSorted() || unsorted.getField(0).first != "c") {
+		std::cout << "Reading into a sorted node should not keep it sorted" << std::endl;
+		++errors;
+	}
+	return errors;
+}
+
+int testNodeBuilder() {
+	std::string text = "{\"a\": [1, 2.5, \"x\", [true, false, null], {}], \"b\": {\"c\": {\"d\": []}}, \"e\": \"long string value\"} 7";
+	JsonParser<std::string> parser(text);
+	JsonNode expected;
+	expected.read(parser);
+	int errors = 0;
+	JsonParser<std::string> stepParser(text);
+	JsonNode node;
+	JsonNodeBuilder<std::string> builder(stepParser, node);
+	int steps = 1;
+	while (!builder.step(8)) {
+		++steps;
+	}
+	if (node != expected || steps < 5 || stepParser.currentToken() != JsonToken::VALUE_NUMBER_INT) {
+		std::cout << "Building a node in " << steps << " steps gave the wrong result" << std::endl;
+		++errors;
+	}
+	builder.reset(node);
+	while (!builder.step(std::chrono::microseconds(100))) {
+	}
+	if (node.asInteger() != 7) {
+		std::cout << "Timed steps did not build the next node" << std::endl;
+		++errors;
+	}
+	return errors;
+}
+
+int testCompactDocument() {
+	std::string text = "{\"a\": [1, 2.5, \"x\", [true, false, null], {}], \"b\": {\"c\": {\"d\": []}}, \"e\": \"long string value\", \"f\": -3}";
+	JsonParser<std::string> parser(text);
+	JsonNode node;
+	node.read(parser);
+	int errors = 0;
+	for (CompactJsonOrder order : {CompactJsonOrder::BREADTH_FIRST, CompactJsonOrder::DEPTH_FIRST}) {
+		CompactJsonDocument doc(node, order);
+		CompactJsonDocument::Node root = doc.root();
+		std::string output;
+		{
+			JsonGenerator<std::string> generator(output, false);
+			root.write(generator);
+		}
+		JsonNode expanded;
+		root.expand(expanded);
+		if (output != toString(node) || root.hash() != node.hash() || expanded != node || doc.getNodeCount() != 15) {
+			std::cout << "Compact document does not match " << toString(node) << ": " << output << std::endl;
+			++errors;
+		}
+		if (root["a"][1].asDouble() != 2.5 || root["a"][3][0].asBoolean() != true || root["e"].asString() != "long string value"
+				|| root.getFieldName(3) != "f" || root["f"].asInteger() != -3 || !root["g"].isNull() || root["b"]["c"]["d"].size() != 0) {
+			std::cout << "Compact document lookups are wrong" << std::endl;
+			++errors;
+		}
+	}
+	return errors;
+}
+
+int testFieldHandle() {
+	std::string text = "[{\"id\": 1, \"price\": 2.5}, {\"id\": 2, \"price\": 3.5}, {\"price\": 4.5, \"id\": 3}, {\"id\": 4}, 5]";
+	JsonParser<std::string> parser(text);
+	JsonNode node;
+	node.read(parser);
+	int errors = 0;
+	JsonFieldHandle price("price");
+	double total = 0.0;
+	for (size_t i = 0; i < node.size(); ++i) {
+		total += price.get(node[i]).asDouble(0.0);
+	}
+	uint64_t hash = node[1].hash();
+	JsonNode* field = price.find(node[1]);
+	*field = 6.5;
+	if (total != 10.5 || price.find(node[3]) != nullptr || node[1]["price"].asDouble() != 6.5 || node[1].hash() == hash) {
+		std::cout << "Field handle lookups are wrong: " << total << std::endl;
+		++errors;
+	}
+	// A repeated key is found at the remembered index, not necessarily first
+	std::string repeated = "{\"price\": 1, \"price\": 2}";
+	JsonParser<std::string> repeatedParser(repeated);
+	JsonNode twice;
+	twice.read(repeatedParser);
+	if (twice["price"].asInteger() != 1 || price.get(twice).asInteger() != 2) {
+		std::cout << "Field handle found the wrong repeated key" << std::endl;
+		++errors;
+	}
+	return errors;
+}
+
+int main(int /*argc*/, char* /*argv*/[]) {
+	int numErrors = 0;
+	int errors;
+	try {
+		errors = testLogSink();
+		std::cout << "Num log sink errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testObjectPool();
+		std::cout << "Num object pool errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testParallelWriter();
+		std::cout << "Num parallel writer errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testPipeline();
+		std::cout << "Num pipeline errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testBatchNames();
+		std::cout << "Num batch name errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testIndex(false);
+		std::cout << "Num array index errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testIndex(true);
+		std::cout << "Num sequence index errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testCheckpoint();
+		std::cout << "Num checkpoint errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testFilter();
+		std::cout << "Num filter errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testQuery();
+		std::cout << "Num query errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testSort();
+		std::cout << "Num sort errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testAggregate();
+		std::cout << "Num aggregate errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testStatistics();
+		std::cout << "Num statistics errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testCsv();
+		std::cout << "Num CSV errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testCanonical();
+		std::cout << "Num canonical errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testPatch();
+		std::cout << "Num patch errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testStreamingPatch();
+		std::cout << "Num streaming patch errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testHash();
+		std::cout << "Num hash errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testStringPool();
+		std::cout << "Num string pool errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testRecycler();
+		std::cout << "Num recycler errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testSizeHints();
+		std::cout << "Num size hint errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testNodeSemantics();
+		std::cout << "Num node semantics errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testSortKeys();
+		std::cout << "Num sort keys errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testNodeBuilder();
+		std::cout << "Num node builder errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testCompactDocument();
+		std::cout << "Num compact document errors: " << errors << std::endl;
+		numErrors += errors;
+		errors = testFieldHandle();
+		std::cout << "Num field handle errors: " << errors << std::endl;
+		numErrors += errors;
+	} catch (const JsonException& e) {
+		std::cout << "Unexpected exception: " << e.what() << std::endl;
+		++numErrors;
+	}
+
+	std::cout << "Total num errors: " << numErrors << std::endl;
+	return numErrors;
+}
@@ -25,61 +25,43 @@
 #include <iostream>
 #include <jaxup.h>
 
+#include "batch.h"
+
 using namespace jaxup;
 
 int streamingCopy(FILE* inputFile, FILE* outputFile, bool prettify) {
-	JsonFactory factory;
+	JsonPooledFactory factory;
 	auto parser = factory.createJsonParser(inputFile);
 	auto generator = factory.createJsonGenerator(outputFile, prettify);
-	JsonToken token;
 	int i = 0;
-	while ((token = parser->nextToken()) != JsonToken::NOT_AVAILABLE) {
-		switch (token) {
-		case JsonToken::END_ARRAY:
-			generator->endArray();
-			break;
-		case JsonToken::END_OBJECT:
-			generator->endObject();
-			break;
-		case JsonToken::FIELD_NAME:
-			generator->writeFieldName(parser->getCurrentName());
-			break;
-		case JsonToken::START_ARRAY:
-			generator->startArray();
-			break;
-		case JsonToken::START_OBJECT:
-			generator->startObject();
-			break;
-		case JsonToken::VALUE_FALSE:
-			generator->write(false);
-			break;
-		case JsonToken::VALUE_NULL:
-			generator->write(nullptr);
-			break;
-		case JsonToken::VALUE_NUMBER_FLOAT:
-			generator->write(parser->getDoubleValue());
-			break;
-		case JsonToken::VALUE_NUMBER_INT:
-			generator->write(parser->getIntegerValue());
-			break;
-		case JsonToken::VALUE_STRING:
-			generator->write(parser->getText());
-			break;
-		case JsonToken::VALUE_TRUE:
-			generator->write(true);
-			break;
-		case JsonToken::NOT_AVAILABLE:
-			break;
-		}
+	while (parser->nextToken() != JsonToken::NOT_AVAILABLE) {
+		generator->copyCurrentEvent(*parser);
 		++i;
 	}
 
 	return i;
 }
 
+int pipelinedCopy(FILE* inputFile, FILE* outputFile, bool prettify) {
+	JsonFactory factory;
+	auto parser = factory.createJsonParser(inputFile);
+	auto generator = factory.createJsonGenerator(outputFile, prettify);
+	return static_cast<int>(runJsonPipeline(*parser, *generator, nullptr));
+}
+
 int main(int argc, char* argv[]) {
+	if (argc > 1 && std::string("--batch") == argv[1]) {
+		BatchOptions options;
+		if (!parseBatchArgs(argc, argv, 2, true, options)) {
+			std::cerr << "Expected format: " << argv[0] << " --batch outputDir [--threads N] [--prettify] inputFilesOrDirectories..." << std::endl;
+			return 1;
+		}
+		return runBatch(options, "token", [&options](const std::string& input, const std::string& outputName) {
+			return copyBatchFile(input, outputName, options, streamingCopy);
+		}) == 0 ? 0 : 1;
+	}
 	if (argc < 3) {
-		std::cerr << "Expected format: " << argv[0] << " inputFile outputFile" << std::endl;
+		std::cerr << "Expected format: " << argv[0] << " inputFile outputFile [--prettify] [--pipeline]" << std::endl;
 		return 1;
 	}
 	auto start = std::chrono::high_resolution_clock::now();
@@ -88,13 +70,22 @@ int main(int argc, char* argv[]) {
 	FILE* inputFile = fopen(argv[1], "r");
 	FILE* outputFile = fopen(argv[2], "w");
 	bool prettify = false;
-	if (argc > 3 && std::string("--prettify") == argv[3]) {
-		prettify = true;
+	bool pipeline = false;
+	for (int arg = 3; arg < argc; ++arg) {
+		if (std::string("--prettify") == argv[arg]) {
+			prettify = true;
+		} else if (std::string("--pipeline") == argv[arg]) {
+			pipeline = true;
+		}
 	}
 
 	int numTokens = 0;
 	try {
-		numTokens = streamingCopy(inputFile, outputFile, prettify);
+		if (pipeline) {
+			numTokens = pipelinedCopy(inputFile, outputFile, prettify);
+		} else {
+			numTokens = streamingCopy(inputFile, outputFile, prettify);
+		}
 	} catch (const JsonException& e) {
 		std::cerr << "Failed to uglify file: " << e.what() << std::endl;
 		return 1;